@@ -0,0 +1,93 @@
+// Measures how the all-pairs route precomputation of graph::Router scales with the number of threads,
+// for both route table layouts.
+// Usage: apsp_benchmark [vertex_count = 4096] [max_thread_count = hardware threads]
+
+#include "../src/headers/router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr size_t EDGES_PER_VERTEX = 8;
+
+// A random sparse graph resembling a transport network: every vertex has a few outgoing edges
+// to the vertices with close ids, plus a rare long-range one.
+graph::DirectedWeightedGraph<double> MakeSyntheticGraph(size_t vertex_count) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> weight_distribution(1.0, 30.0);
+    std::uniform_int_distribution<size_t> offset_distribution(1, 64);
+    std::uniform_int_distribution<size_t> vertex_distribution(0, vertex_count - 1);
+
+    graph::DirectedWeightedGraph<double> graph(vertex_count);
+    for (graph::VertexId from = 0; from < vertex_count; ++from) {
+        for (size_t i = 0; i < EDGES_PER_VERTEX; ++i) {
+            const graph::VertexId to = i == 0 ? vertex_distribution(generator) : (from + offset_distribution(generator)) % vertex_count;
+            graph.AddEdge({from, to, 1, weight_distribution(generator)});
+        }
+    }
+    return graph;
+}
+
+// A sum of route weights over a sample of pairs, to check that all thread counts compute the same routes.
+template <typename RouteTable>
+double ComputeChecksum(const graph::Router<double, RouteTable>& router, size_t vertex_count) {
+    double checksum = 0;
+    for (graph::VertexId from = 0; from < vertex_count; from += 97) {
+        for (graph::VertexId to = 0; to < vertex_count; to += 89) {
+            if (const auto route = router.BuildRoute(from, to)) {
+                checksum += route->weight + route->edges.size();
+            }
+        }
+    }
+    return checksum;
+}
+
+// Times the precomputation with the given route table layout for 1, 2, 4, ..., `max_thread_count` threads.
+template <typename RouteTable>
+void RunBenchmark(const std::string& layout_name, size_t cell_size, const graph::CsrGraph<double>& graph,
+                  size_t max_thread_count) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::cout << layout_name << " route table (" << cell_size << " bytes per cell, "
+              << vertex_count * vertex_count * cell_size / (1024 * 1024) << " MiB):" << std::endl;
+
+    double single_thread_seconds = 0;
+    std::optional<double> reference_checksum;
+    for (size_t thread_count = 1; ; thread_count = std::min(thread_count * 2, max_thread_count)) {
+        const auto start = std::chrono::steady_clock::now();
+        const graph::Router<double, RouteTable> router(graph, thread_count);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const double checksum = ComputeChecksum(router, vertex_count);
+        if (!reference_checksum) {
+            reference_checksum = checksum;
+            single_thread_seconds = elapsed.count();
+        }
+        std::cout << std::setw(3) << thread_count << " thread(s): " << std::fixed << std::setprecision(3)
+                  << elapsed.count() << " s, speedup x" << std::setprecision(2) << single_thread_seconds / elapsed.count()
+                  << (std::abs(checksum - *reference_checksum) < 1e-6 * std::abs(*reference_checksum) ? "" : "  [ROUTES DIFFER]")
+                  << std::endl;
+        if (thread_count >= max_thread_count) {
+            break;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t vertex_count = argc > 1 ? std::stoul(argv[1]) : 4096;
+    const size_t max_thread_count = argc > 2 ? std::stoul(argv[2]) : threading::ThreadPool::GetDefaultThreadCount();
+
+    const graph::CsrGraph<double> graph = MakeSyntheticGraph(vertex_count).Freeze();
+    std::cout << "Vertices: " << vertex_count << ", edges: " << graph.GetEdgeCount() << std::endl;
+
+    RunBenchmark<graph::ExactRouteTable<double>>("Exact", 32, graph, max_thread_count);
+    RunBenchmark<graph::CompactRouteTable<double>>("Compact", sizeof(float) + sizeof(uint32_t), graph, max_thread_count);
+}
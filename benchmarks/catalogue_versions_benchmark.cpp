@@ -0,0 +1,157 @@
+// Measures answering bus and stop stat requests from snapshots of Transportation::CatalogueVersions while a writer
+// publishes new versions, against answering them with no versions being published. Every version adds a bus passing
+// all of the stops, so the readers check that each snapshot is consistent with its version number: a version that
+// changed or got freed under a reader would show in the counts. Checks that the retired versions get reclaimed.
+// Usage: catalogue_versions_benchmark [reader_count = 4] [version_count = 200] [stop_count = 2000]
+
+#include "../src/headers/catalogue_versions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace Transportation;
+
+constexpr size_t BASE_BUS_COUNT = 200;
+constexpr size_t BUS_STOPS_COUNT = 20;
+
+std::string GetStopName(size_t i) {
+    return "Stop " + std::to_string(i);
+}
+
+std::string GetBusName(size_t i) {
+    return "Bus " + std::to_string(i);
+}
+
+// Buses of random stops, as version 0.
+TransportCatalogue MakeCatalogue(size_t stop_count) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> lat_distribution(55.5, 56.0);
+    std::uniform_real_distribution<double> lng_distribution(37.2, 38.0);
+    std::uniform_int_distribution<size_t> stop_distribution(0, stop_count - 1);
+    TransportCatalogue catalogue;
+    for (size_t i = 0; i < stop_count; ++i) {
+        catalogue.AddStop(GetStopName(i), {lat_distribution(generator), lng_distribution(generator)});
+    }
+    for (size_t i = 0; i < BASE_BUS_COUNT; ++i) {
+        std::vector<Stop*> stops;
+        for (size_t j = 0; j < BUS_STOPS_COUNT; ++j) {
+            stops.push_back(catalogue.FindStop(GetStopName(stop_distribution(generator))));
+        }
+        catalogue.AddBus(GetBusName(i), std::move(stops), false);
+    }
+    catalogue.Finalize();
+    return catalogue;
+}
+
+struct ReaderResult {
+    size_t request_count = 0;
+    size_t inconsistent_count = 0;
+};
+
+// Answers a bus and a stop request from every snapshot taken, as a stat handler would, until `stop` is set.
+ReaderResult RunReader(const CatalogueVersions& versions, size_t stop_count, unsigned seed, const std::atomic<bool>& stop) {
+    std::mt19937 generator(seed);
+    ReaderResult result;
+    while (!stop.load(std::memory_order_relaxed)) {
+        const CatalogueSnapshot snapshot = versions.Acquire();
+        const size_t bus_count = BASE_BUS_COUNT + snapshot.GetVersion();
+        const BusResponse bus = snapshot->GetRoute(GetBusName(generator() % bus_count));
+        const Stop* stop_ptr = snapshot->FindStop(GetStopName(generator() % stop_count));
+        const size_t stop_bus_count = snapshot->GetStopBusesList(stop_ptr).size();
+        // every bus published after version 0 passes every stop
+        if (snapshot->GetBusCount() != bus_count || snapshot->GetAllBuses().size() != bus_count
+            || bus.stops_number == 0 || stop_bus_count < snapshot.GetVersion()) {
+            ++result.inconsistent_count;
+        }
+        result.request_count += 2;
+    }
+    return result;
+}
+
+struct RunResult {
+    double requests_per_second = 0;
+    size_t inconsistent_count = 0;
+    size_t published_count = 0;
+    double publish_seconds = 0;
+};
+
+// Runs the readers for `seconds`, or for as long as publishing `version_count` versions takes, if that is more.
+RunResult Run(size_t reader_count, size_t version_count, size_t stop_count, double seconds) {
+    CatalogueVersions versions(MakeCatalogue(stop_count));
+    std::atomic<bool> stop{false};
+    std::vector<ReaderResult> results(reader_count);
+    std::vector<std::thread> readers;
+    const auto start_time = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < reader_count; ++i) {
+        readers.emplace_back([&, i] { results[i] = RunReader(versions, stop_count, static_cast<unsigned>(i), stop); });
+    }
+
+    RunResult run_result;
+    for (size_t i = 0; i < version_count; ++i) {
+        const auto publish_start_time = std::chrono::steady_clock::now();
+        CatalogueBuilder builder(versions);
+        TransportCatalogue& catalogue = builder.GetCatalogue();
+        std::vector<Stop*> stops;
+        for (size_t j = 0; j < stop_count; ++j) {
+            stops.push_back(catalogue.FindStop(GetStopName(j)));
+        }
+        catalogue.AddBus(GetBusName(BASE_BUS_COUNT + i), std::move(stops), true);
+        builder.Publish();
+        run_result.publish_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - publish_start_time).count();
+        ++run_result.published_count;
+    }
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() < seconds) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    const double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    size_t request_count = 0;
+    for (const ReaderResult& result : results) {
+        request_count += result.request_count;
+        run_result.inconsistent_count += result.inconsistent_count;
+    }
+    run_result.requests_per_second = request_count / elapsed_seconds;
+    versions.Reclaim(); // the versions released since the last Publish
+    if (versions.GetVersionCount() != 1) {
+        std::cout << "  [" << versions.GetVersionCount() - 1 << " RETIRED VERSIONS NOT RECLAIMED]" << std::endl;
+        ++run_result.inconsistent_count;
+    }
+    return run_result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t reader_count = argc > 1 ? std::stoul(argv[1]) : 4;
+    const size_t version_count = argc > 2 ? std::stoul(argv[2]) : 200;
+    const size_t stop_count = argc > 3 ? std::stoul(argv[3]) : 2000;
+    std::cout << reader_count << " readers, " << version_count << " versions published, " << stop_count << " stops, "
+              << BASE_BUS_COUNT << " buses to start with" << std::endl;
+
+    const RunResult publishing = Run(reader_count, version_count, stop_count, 0);
+    const RunResult quiet = Run(reader_count, 0, stop_count, 1.0);
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "  no versions published:    " << quiet.requests_per_second << " requests/s" << std::endl;
+    std::cout << "  publishing versions:      " << publishing.requests_per_second << " requests/s, "
+              << std::setprecision(2) << publishing.publish_seconds * 1000 / std::max<size_t>(publishing.published_count, 1)
+              << " ms to copy, change and publish a version" << std::endl;
+    const size_t inconsistent_count = publishing.inconsistent_count + quiet.inconsistent_count;
+    std::cout << "  " << (inconsistent_count == 0 ? "snapshots are consistent, retired versions reclaimed"
+                                                   : "[" + std::to_string(inconsistent_count) + " INCONSISTENT SNAPSHOTS]") << std::endl;
+    return inconsistent_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// Compares computing the lengths of bus routes as the crow flies with geo::ComputeDistance, which takes the sines and
+// cosines of both points for every pair, against geo::ComputePathDistances over coordinates prepared once per stop,
+// the way TransportCatalogue counts route lengths. Checks that the batched distances stay within rounding of the scalar ones.
+// Usage: distance_kernel_benchmark [stop_count = 10000] [route_count = 20000]
+
+#include "../src/headers/geo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t ROUTE_STOPS_COUNT = 40;
+constexpr size_t REPEAT_COUNT = 5;
+// A meter apart, the arc cosine turns the rounding of either formula into millimeters; farther points are more precise.
+constexpr double MAX_ERROR = 0.01; // in meters
+
+// Stops of a city, plus a few spread over the globe, a few at the same place as another stop, and a few about a meter away
+// from the stop added before them.
+std::vector<geo::Coordinates> MakeStops(size_t stop_count) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> lat_distribution(55.5, 56.0);
+    std::uniform_real_distribution<double> lng_distribution(37.2, 38.0);
+    std::uniform_real_distribution<double> global_lat_distribution(-90.0, 90.0);
+    std::uniform_real_distribution<double> global_lng_distribution(-180.0, 180.0);
+    std::vector<geo::Coordinates> stops;
+    stops.reserve(stop_count);
+    while (stops.size() < stop_count) {
+        switch (generator() % 50) {
+            case 0: stops.push_back({global_lat_distribution(generator), global_lng_distribution(generator)}); break;
+            case 1: stops.push_back(stops.empty() ? geo::Coordinates{55.75, 37.6} : stops[generator() % stops.size()]); break;
+            case 2: {
+                const geo::Coordinates other = stops.empty() ? geo::Coordinates{55.75, 37.6} : stops.back();
+                stops.push_back({other.lat + 1e-5, other.lng - 1e-5});
+                break;
+            }
+            default: stops.push_back({lat_distribution(generator), lng_distribution(generator)}); break;
+        }
+    }
+    return stops;
+}
+
+// Routes of random stops, some of them passing a stop twice in a row or moving to the next stop added.
+std::vector<std::vector<uint32_t>> MakeRoutes(size_t stop_count, size_t route_count) {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<uint32_t> stop_distribution(0, static_cast<uint32_t>(stop_count - 1));
+    std::vector<std::vector<uint32_t>> routes(route_count);
+    for (std::vector<uint32_t>& route : routes) {
+        route.push_back(stop_distribution(generator));
+        while (route.size() < ROUTE_STOPS_COUNT) {
+            switch (generator() % 20) {
+                case 0: route.push_back(route.back()); break;
+                case 1: route.push_back(std::min(route.back() + 1, static_cast<uint32_t>(stop_count - 1))); break;
+                default: route.push_back(stop_distribution(generator)); break;
+            }
+        }
+    }
+    return routes;
+}
+
+double GetSecondsSince(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t stop_count = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const size_t route_count = argc > 2 ? std::stoul(argv[2]) : 20000;
+
+    const std::vector<geo::Coordinates> stops = MakeStops(stop_count);
+    const std::vector<std::vector<uint32_t>> routes = MakeRoutes(stop_count, route_count);
+    const size_t pair_count = route_count * (ROUTE_STOPS_COUNT - 1) * REPEAT_COUNT;
+    std::cout << stop_count << " stops, " << route_count << " routes of " << ROUTE_STOPS_COUNT << " stops, "
+              << REPEAT_COUNT << " passes" << std::endl;
+
+    auto start_time = std::chrono::steady_clock::now();
+    double scalar_checksum = 0;
+    for (size_t pass = 0; pass < REPEAT_COUNT; ++pass) {
+        for (const std::vector<uint32_t>& route : routes) {
+            for (size_t i = 0; i + 1 < route.size(); ++i) {
+                scalar_checksum += geo::ComputeDistance(stops[route[i]], stops[route[i + 1]]);
+            }
+        }
+    }
+    const double scalar_seconds = GetSecondsSince(start_time);
+
+    start_time = std::chrono::steady_clock::now();
+    std::vector<geo::PreparedCoordinates> prepared_stops;
+    prepared_stops.reserve(stops.size());
+    for (const geo::Coordinates& stop : stops) {
+        prepared_stops.push_back(geo::PrepareCoordinates(stop));
+    }
+    const double prepare_seconds = GetSecondsSince(start_time);
+
+    start_time = std::chrono::steady_clock::now();
+    double prepared_checksum = 0;
+    for (size_t pass = 0; pass < REPEAT_COUNT; ++pass) {
+        for (const std::vector<uint32_t>& route : routes) {
+            for (size_t i = 0; i + 1 < route.size(); ++i) {
+                prepared_checksum += geo::ComputeDistance(prepared_stops[route[i]], prepared_stops[route[i + 1]]);
+            }
+        }
+    }
+    const double prepared_seconds = GetSecondsSince(start_time);
+
+    start_time = std::chrono::steady_clock::now();
+    double batched_checksum = 0;
+    std::vector<double> distances(ROUTE_STOPS_COUNT);
+    for (size_t pass = 0; pass < REPEAT_COUNT; ++pass) {
+        for (const std::vector<uint32_t>& route : routes) {
+            geo::ComputePathDistances(prepared_stops.data(), route.data(), route.size(), distances.data());
+            for (size_t i = 0; i + 1 < route.size(); ++i) {
+                batched_checksum += distances[i];
+            }
+        }
+    }
+    const double batched_seconds = GetSecondsSince(start_time);
+
+    // every batched distance against the scalar one
+    double max_absolute_error = 0;
+    double max_relative_error = 0;
+    size_t failed_count = 0;
+    for (const std::vector<uint32_t>& route : routes) {
+        geo::ComputePathDistances(prepared_stops.data(), route.data(), route.size(), distances.data());
+        for (size_t i = 0; i + 1 < route.size(); ++i) {
+            const double expected = geo::ComputeDistance(stops[route[i]], stops[route[i + 1]]);
+            const double error = std::abs(distances[i] - expected);
+            const double relative_error = expected >= 1000 ? error / expected : 0.0;
+            max_absolute_error = std::max(max_absolute_error, error);
+            max_relative_error = std::max(max_relative_error, relative_error);
+            if (error > MAX_ERROR) {
+                ++failed_count;
+            }
+        }
+    }
+
+    const auto print_row = [pair_count](const std::string& name, double seconds, double checksum) {
+        std::cout << "  " << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(2)
+                  << seconds * 1e9 / pair_count << " ns per pair, total " << std::setprecision(0) << checksum << " m" << std::endl;
+    };
+    print_row("ComputeDistance:", scalar_seconds, scalar_checksum);
+    print_row("prepared ComputeDistance:", prepared_seconds, prepared_checksum);
+    print_row("ComputePathDistances:", batched_seconds, batched_checksum);
+    std::cout << "  preparing the stops took " << std::setprecision(4) << prepare_seconds << " s, batched distances are x"
+              << std::setprecision(1) << scalar_seconds / batched_seconds << " faster" << std::endl;
+    std::cout << "  max error " << std::scientific << std::setprecision(2) << max_absolute_error << " m, "
+              << max_relative_error << " relative beyond a kilometer: "
+              << (failed_count == 0 ? "within rounding" : "[" + std::to_string(failed_count) + " DISTANCES DIFFER]") << std::endl;
+    return failed_count == 0 ? 0 : 1;
+}
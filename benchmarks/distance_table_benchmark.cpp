@@ -0,0 +1,146 @@
+// Compares road distance lookups in Transportation::StopDistanceTable with the hash map keyed by stop pointers
+// it has replaced in TransportCatalogue, on a synthetic network. Lookups follow bus routes in both directions,
+// so about half of them fall back to the distance set for the opposite direction.
+// Usage: distance_table_benchmark [stop_count = 100000] [lookup_count = 10000000]
+
+#include "../src/headers/stop_distance_table.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace Transportation;
+
+constexpr size_t NEIGHBOURS_PER_STOP = 4;
+
+// The map and the hasher TransportCatalogue used to keep road distances in.
+class StopPairHasher {
+public:
+    size_t operator()(const std::pair<const Stop*, const Stop*> hashing_pair) const noexcept {
+        uint64_t num = std::hash<const void*>{}(hashing_pair.first) * 2 + std::hash<const void*>{}(hashing_pair.second) * 8;
+        return static_cast<size_t>(num);
+    }
+};
+
+using StopPairMap = std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopPairHasher>;
+
+int GetMapDistance(const StopPairMap& distances, const Stop* first_stop, const Stop* second_stop) {
+    if (distances.count({first_stop, second_stop})) {
+        return distances.at({first_stop, second_stop});
+    }
+    else if (distances.count({second_stop, first_stop})) {
+        return distances.at({second_stop, first_stop});
+    }
+    return 0;
+}
+
+struct RoadSpec {
+    StopId from;
+    StopId to;
+    int distance;
+};
+
+// Every stop is joined to a few stops with close ids; a quarter of the roads have their opposite direction set too.
+std::vector<RoadSpec> MakeRoads(size_t stop_count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> offset_distribution(1, 32);
+    std::uniform_int_distribution<int> distance_distribution(100, 3000);
+    std::vector<RoadSpec> roads;
+    for (size_t from = 0; from < stop_count; ++from) {
+        for (size_t i = 0; i < NEIGHBOURS_PER_STOP; ++i) {
+            const StopId to = static_cast<StopId>((from + offset_distribution(generator)) % stop_count);
+            roads.push_back({static_cast<StopId>(from), to, distance_distribution(generator)});
+            if (generator() % 4 == 0) {
+                roads.push_back({to, static_cast<StopId>(from), distance_distribution(generator)});
+            }
+        }
+    }
+    return roads;
+}
+
+// Pairs of stops to look the distances up for: set roads in either direction, and a few pairs without a road.
+std::vector<std::pair<StopId, StopId>> MakeLookups(const std::vector<RoadSpec>& roads, size_t stop_count, size_t lookup_count) {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<size_t> road_distribution(0, roads.size() - 1);
+    std::uniform_int_distribution<StopId> stop_distribution(0, static_cast<StopId>(stop_count - 1));
+    std::vector<std::pair<StopId, StopId>> lookups;
+    lookups.reserve(lookup_count);
+    while (lookups.size() < lookup_count) {
+        const RoadSpec& road = roads[road_distribution(generator)];
+        switch (generator() % 8) {
+            case 0: lookups.emplace_back(stop_distribution(generator), stop_distribution(generator)); break;
+            case 1: case 2: case 3: lookups.emplace_back(road.to, road.from); break;
+            default: lookups.emplace_back(road.from, road.to); break;
+        }
+    }
+    return lookups;
+}
+
+double GetSecondsSince(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t stop_count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const size_t lookup_count = argc > 2 ? std::stoul(argv[2]) : 10000000;
+
+    std::deque<Stop> stops;
+    for (size_t i = 0; i < stop_count; ++i) {
+        stops.push_back({"Stop " + std::to_string(i), {}, static_cast<StopId>(i)});
+    }
+    const std::vector<RoadSpec> roads = MakeRoads(stop_count);
+    const std::vector<std::pair<StopId, StopId>> lookups = MakeLookups(roads, stop_count, lookup_count);
+    std::cout << stop_count << " stops, " << roads.size() << " distances, " << lookup_count << " lookups" << std::endl;
+
+    auto start_time = std::chrono::steady_clock::now();
+    StopPairMap map;
+    for (const RoadSpec& road : roads) {
+        map[{&stops[road.from], &stops[road.to]}] = road.distance;
+    }
+    const double map_build_seconds = GetSecondsSince(start_time);
+    start_time = std::chrono::steady_clock::now();
+    int64_t map_checksum = 0;
+    for (const auto& [from, to] : lookups) {
+        map_checksum += GetMapDistance(map, &stops[from], &stops[to]);
+    }
+    const double map_lookup_seconds = GetSecondsSince(start_time);
+
+    start_time = std::chrono::steady_clock::now();
+    StopDistanceTable table;
+    for (const RoadSpec& road : roads) {
+        table.Set(road.from, road.to, road.distance);
+    }
+    const double table_build_seconds = GetSecondsSince(start_time);
+    start_time = std::chrono::steady_clock::now();
+    int64_t table_checksum = 0;
+    for (const auto& [from, to] : lookups) {
+        table_checksum += table.Get(from, to);
+    }
+    const double table_lookup_seconds = GetSecondsSince(start_time);
+
+    // a node of the map: the next pointer, the key, the value and the cached hash, plus a bucket pointer per element
+    const size_t map_memory = map.size() * (sizeof(void*) + sizeof(StopPairMap::value_type) + sizeof(size_t))
+                              + map.bucket_count() * sizeof(void*);
+    const auto print_row = [lookup_count](const std::string& name, double build_seconds, double lookup_seconds, size_t memory) {
+        std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed
+                  << "build " << std::setprecision(4) << build_seconds << " s, lookup " << std::setprecision(1)
+                  << lookup_seconds * 1e9 / lookup_count << " ns, ~" << memory / (1 << 20) << " MB" << std::endl;
+    };
+    print_row("unordered_map of pointers:", map_build_seconds, map_lookup_seconds, map_memory);
+    print_row("StopDistanceTable:", table_build_seconds, table_lookup_seconds, table.GetMemoryUsage());
+    std::cout << "  lookups are x" << std::setprecision(1) << map_lookup_seconds / table_lookup_seconds << " faster, "
+              << (map_checksum == table_checksum ? "distances match" : "[DISTANCES DIFFER]") << std::endl;
+    return map_checksum == table_checksum ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+// Compares in-place updates of Transportation::Router (adding a bus with a new stop, removing a bus) with building
+// the router anew, for every backend. The new bus is then removed and added again a few times, its edges taking back
+// the ids of the removed ones. Routes of the updated router are checked against the rebuilt one.
+// Stops are about 300 m apart along a row and 550 m along a column; a positive walk distance joins the ones within it by walks.
+// Usage: router_update_benchmark [grid_side = 30] [max_walk_distance = 0]
+
+#include "../src/headers/transport_router.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace Transportation;
+
+constexpr size_t BUS_STOPS_COUNT = 12;
+constexpr size_t SAMPLE_QUERY_COUNT = 500;
+constexpr size_t READD_CYCLE_COUNT = 5;
+constexpr double WALKING_SPEED = 5.0;
+const std::string NEW_STOP_NAME = "New stop";
+const std::string NEW_BUS_NAME = "New bus";
+
+struct BusSpec {
+    std::string name;
+    std::vector<size_t> stops; // indices in the stop grid, NEW_STOP_INDEX for the new stop
+    bool round_route;
+};
+
+constexpr size_t NEW_STOP_INDEX = static_cast<size_t>(-1);
+
+// Random walks over a grid of stops, some of them round.
+std::vector<BusSpec> MakeBusSpecs(size_t grid_side, size_t bus_count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> stop_distribution(0, grid_side * grid_side - 1);
+    std::uniform_int_distribution<int> step_distribution(0, 3);
+
+    std::vector<BusSpec> specs;
+    for (size_t bus = 0; bus < bus_count; ++bus) {
+        BusSpec spec{"Bus " + std::to_string(bus), {stop_distribution(generator)}, bus % 3 == 0};
+        while (spec.stops.size() < BUS_STOPS_COUNT) {
+            const size_t stop = spec.stops.back();
+            const size_t row = stop / grid_side;
+            const size_t column = stop % grid_side;
+            switch (step_distribution(generator)) {
+                case 0: spec.stops.push_back(row + 1 < grid_side ? stop + grid_side : stop - grid_side); break;
+                case 1: spec.stops.push_back(row > 0 ? stop - grid_side : stop + grid_side); break;
+                case 2: spec.stops.push_back(column + 1 < grid_side ? stop + 1 : stop - 1); break;
+                default: spec.stops.push_back(column > 0 ? stop - 1 : stop + 1); break;
+            }
+        }
+        if (spec.round_route) {
+            spec.stops.push_back(spec.stops.front());
+        }
+        specs.push_back(std::move(spec));
+    }
+    return specs;
+}
+
+geo::Coordinates GetStopCoordinates(size_t grid_side, size_t stop) {
+    if (stop == NEW_STOP_INDEX) { // in the middle of the grid
+        return {55.0 + grid_side * 0.005 / 2 + 0.0025, 37.0 + grid_side * 0.005 / 2 + 0.0025};
+    }
+    return {55.0 + stop / grid_side * 0.005, 37.0 + stop % grid_side * 0.005};
+}
+
+std::string GetStopName(size_t stop) {
+    return stop == NEW_STOP_INDEX ? NEW_STOP_NAME : "Stop " + std::to_string(stop);
+}
+
+void AddBus(TransportCatalogue& catalogue, size_t grid_side, const BusSpec& spec) {
+    std::vector<Stop*> stops;
+    for (const size_t stop : spec.stops) {
+        stops.push_back(catalogue.FindStop(GetStopName(stop)));
+    }
+    for (size_t i = 1; i < spec.stops.size(); ++i) { // roads are a bit longer than straight lines
+        const double distance = geo::ComputeDistance(GetStopCoordinates(grid_side, spec.stops[i - 1]),
+                                                     GetStopCoordinates(grid_side, spec.stops[i]));
+        catalogue.SetStopDistance(stops[i - 1], stops[i], static_cast<int>(distance * 1.3) + 1);
+    }
+    catalogue.AddBus(std::string(spec.name), std::move(stops), spec.round_route);
+}
+
+void FillCatalogue(TransportCatalogue& catalogue, size_t grid_side, const std::vector<BusSpec>& specs, bool with_new_stop) {
+    for (size_t stop = 0; stop < grid_side * grid_side; ++stop) {
+        catalogue.AddStop(GetStopName(stop), GetStopCoordinates(grid_side, stop));
+    }
+    if (with_new_stop) {
+        catalogue.AddStop(std::string(NEW_STOP_NAME), GetStopCoordinates(grid_side, NEW_STOP_INDEX));
+    }
+    for (const BusSpec& spec : specs) {
+        AddBus(catalogue, grid_side, spec);
+    }
+    catalogue.Finalize();
+}
+
+const Bus* FindBus(const TransportCatalogue& catalogue, const std::string& name) {
+    for (const Bus* bus : catalogue.GetAllBuses()) {
+        if (bus->name == name) {
+            return bus;
+        }
+    }
+    return nullptr;
+}
+
+void PrintUpdate(const std::string& name, const RouterUpdateStats& stats, double build_seconds) {
+    std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(4)
+              << stats.seconds << " s (x" << std::setprecision(1) << build_seconds / stats.seconds << " faster than a rebuild), "
+              << stats.added_edges << " edges added, " << stats.removed_edges << " removed"
+              << (stats.rebuilt ? ", backend rebuilt" : "");
+    if (stats.invalidated_trees > 0) {
+        std::cout << ", " << stats.invalidated_trees << " cached trees invalidated";
+    }
+    std::cout << std::endl;
+}
+
+// Number of sampled queries whose travel times differ between the routers.
+size_t CountMismatches(Router& updated, Router& rebuilt, size_t grid_side) {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<size_t> stop_distribution(0, grid_side * grid_side);
+    size_t mismatch_count = 0;
+    for (size_t i = 0; i < SAMPLE_QUERY_COUNT; ++i) {
+        const size_t from = stop_distribution(generator);
+        const size_t to = stop_distribution(generator);
+        const std::string from_name = GetStopName(from == grid_side * grid_side ? NEW_STOP_INDEX : from);
+        const std::string to_name = GetStopName(to == grid_side * grid_side ? NEW_STOP_INDEX : to);
+        const RouteResponse lhs = updated.FindRoute(from_name, to_name);
+        const RouteResponse rhs = rebuilt.FindRoute(from_name, to_name);
+        if (lhs.success != rhs.success || std::abs(lhs.total_time - rhs.total_time) > 1e-6 * (1.0 + rhs.total_time)) {
+            ++mismatch_count;
+        }
+    }
+    return mismatch_count;
+}
+
+// Returns the number of sampled queries the updated router answers differently.
+size_t RunBenchmark(const std::string& backend_name, RouterBackend backend, size_t grid_side, double max_walk_distance) {
+    const size_t bus_count = grid_side * grid_side / 8;
+    std::vector<BusSpec> specs = MakeBusSpecs(grid_side, bus_count);
+    const BusSpec removed_spec = specs.front();
+    BusSpec new_spec = specs.back();
+    new_spec.name = NEW_BUS_NAME;
+    new_spec.stops[new_spec.stops.size() / 2] = NEW_STOP_INDEX;
+
+    RouterConfig config{40.0, 6, backend, 16 << 20};
+    if (max_walk_distance > 0) {
+        config.walking_speed = WALKING_SPEED;
+        config.max_walk_distance = max_walk_distance;
+    }
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue, grid_side, specs, false);
+    Router router(RouterConfig(config), catalogue);
+    std::cout << backend_name << ": built in " << std::fixed << std::setprecision(4) << router.GetBuildSeconds() << " s";
+    if (const std::optional<WalkingTransferStats> walking_stats = router.GetWalkingTransferStats()) {
+        std::cout << ", walks joined in " << walking_stats->seconds << " s: " << walking_stats->walking_edges << " walks, "
+                  << walking_stats->compared_pairs << " pairs of stops compared";
+    }
+    std::cout << std::endl;
+    const auto warm_up_route_cache = [&]() {
+        for (size_t stop = 0; stop < grid_side * grid_side; stop += grid_side + 1) {
+            router.FindRoute(GetStopName(stop), GetStopName(0));
+        }
+    };
+
+    warm_up_route_cache();
+    catalogue.AddStop(std::string(NEW_STOP_NAME), GetStopCoordinates(grid_side, NEW_STOP_INDEX));
+    AddBus(catalogue, grid_side, new_spec);
+    catalogue.Finalize();
+    const RouterUpdateStats add_stats = router.AddBus(FindBus(catalogue, NEW_BUS_NAME), catalogue);
+    warm_up_route_cache();
+    const RouterUpdateStats remove_stats = router.RemoveBus(removed_spec.name);
+    RouterUpdateStats readd_stats;
+    for (size_t i = 0; i < READD_CYCLE_COUNT; ++i) {
+        const RouterUpdateStats cycle_remove_stats = router.RemoveBus(NEW_BUS_NAME);
+        readd_stats = router.AddBus(FindBus(catalogue, NEW_BUS_NAME), catalogue);
+        readd_stats.seconds += cycle_remove_stats.seconds;
+    }
+
+    specs.erase(specs.begin());
+    specs.push_back(new_spec);
+    TransportCatalogue rebuilt_catalogue;
+    FillCatalogue(rebuilt_catalogue, grid_side, specs, true);
+    Router rebuilt_router(RouterConfig(config), rebuilt_catalogue);
+
+    PrintUpdate("add bus with a stop:", add_stats, rebuilt_router.GetBuildSeconds());
+    PrintUpdate("remove bus:", remove_stats, rebuilt_router.GetBuildSeconds());
+    PrintUpdate("remove and add again:", readd_stats, rebuilt_router.GetBuildSeconds());
+    const size_t mismatch_count = CountMismatches(router, rebuilt_router, grid_side);
+    std::cout << "  " << (mismatch_count == 0 ? "routes match the rebuilt router" : "[ROUTES DIFFER] in " + std::to_string(mismatch_count) + " queries")
+              << std::endl;
+    return mismatch_count;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t grid_side = argc > 1 ? std::stoul(argv[1]) : 30;
+    const double max_walk_distance = argc > 2 ? std::stod(argv[2]) : 0.0;
+    std::cout << grid_side * grid_side << " stops, " << grid_side * grid_side / 8 << " buses" << std::endl;
+    size_t mismatch_count = 0;
+    mismatch_count += RunBenchmark("all_pairs", RouterBackend::ALL_PAIRS, grid_side, max_walk_distance);
+    mismatch_count += RunBenchmark("all_pairs_compact", RouterBackend::ALL_PAIRS_COMPACT, grid_side, max_walk_distance);
+    mismatch_count += RunBenchmark("dijkstra", RouterBackend::DIJKSTRA, grid_side, max_walk_distance);
+    mismatch_count += RunBenchmark("a_star", RouterBackend::A_STAR, grid_side, max_walk_distance);
+    mismatch_count += RunBenchmark("bidirectional", RouterBackend::BIDIRECTIONAL, grid_side, max_walk_distance);
+    mismatch_count += RunBenchmark("contraction_hierarchy", RouterBackend::CONTRACTION_HIERARCHY, grid_side, max_walk_distance);
+    mismatch_count += RunBenchmark("raptor", RouterBackend::RAPTOR, grid_side, max_walk_distance);
+    return mismatch_count == 0 ? 0 : 1;
+}
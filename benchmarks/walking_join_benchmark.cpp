@@ -0,0 +1,95 @@
+// Compares finding the pairs of stops within walking distance with Transportation::JoinStopsWithinDistance, the grid join
+// walking transfers of Transportation::Router are built with, against computing the distance for every pair of stops.
+// Stops are scattered over a city-sized area, a few of them in tight clusters, as at large interchanges.
+// Usage: walking_join_benchmark [stop_count = 10000] [max_walk_distance = 400]
+
+#include "../src/headers/stop_spatial_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace Transportation;
+
+constexpr size_t STOPS_PER_CLUSTER = 8;
+
+std::deque<Stop> MakeStops(size_t stop_count) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> lat_distribution(55.5, 56.0);
+    std::uniform_real_distribution<double> lng_distribution(37.2, 38.0);
+    std::normal_distribution<double> cluster_distribution(0.0, 0.0005);
+    std::deque<Stop> stops;
+    while (stops.size() < stop_count) {
+        const geo::Coordinates center{lat_distribution(generator), lng_distribution(generator)};
+        const size_t cluster_size = generator() % 10 == 0 ? STOPS_PER_CLUSTER : 1;
+        for (size_t i = 0; i < cluster_size && stops.size() < stop_count; ++i) {
+            const geo::Coordinates coordinates = i == 0 ? center
+                : geo::Coordinates{center.lat + cluster_distribution(generator), center.lng + cluster_distribution(generator)};
+            stops.push_back({"Stop " + std::to_string(stops.size()), coordinates, static_cast<StopId>(stops.size())});
+        }
+    }
+    return stops;
+}
+
+// Pairs as sorted stop ids, to compare the joins regardless of the order they find pairs in.
+std::vector<std::pair<StopId, StopId>> GetSortedPairs(const std::vector<StopPairDistance>& pairs) {
+    std::vector<std::pair<StopId, StopId>> sorted_pairs;
+    sorted_pairs.reserve(pairs.size());
+    for (const StopPairDistance& pair : pairs) {
+        sorted_pairs.emplace_back(std::min(pair.first->id, pair.second->id), std::max(pair.first->id, pair.second->id));
+    }
+    std::sort(sorted_pairs.begin(), sorted_pairs.end());
+    return sorted_pairs;
+}
+
+double GetSecondsSince(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t stop_count = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const double max_walk_distance = argc > 2 ? std::stod(argv[2]) : 400.0;
+
+    const std::deque<Stop> stops = MakeStops(stop_count);
+    std::vector<const Stop*> stop_ptrs;
+    for (const Stop& stop : stops) {
+        stop_ptrs.push_back(&stop);
+    }
+    std::cout << stop_count << " stops, walks up to " << max_walk_distance << " m" << std::endl;
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<StopPairDistance> naive_pairs;
+    for (size_t i = 0; i < stop_ptrs.size(); ++i) {
+        for (size_t j = i + 1; j < stop_ptrs.size(); ++j) {
+            const double distance = geo::ComputeDistance(stop_ptrs[i]->coordinates, stop_ptrs[j]->coordinates);
+            if (distance <= max_walk_distance) {
+                naive_pairs.push_back({stop_ptrs[i], stop_ptrs[j], distance});
+            }
+        }
+    }
+    const double naive_seconds = GetSecondsSince(start_time);
+
+    SpatialJoinStats join_stats;
+    const std::vector<StopPairDistance> grid_pairs = JoinStopsWithinDistance(stop_ptrs, max_walk_distance, &join_stats);
+
+    const auto print_row = [](const std::string& name, double seconds, size_t compared_pairs, size_t found_pairs) {
+        std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(4)
+                  << seconds << " s, " << compared_pairs << " pairs compared, " << found_pairs * 2 << " walking edges" << std::endl;
+    };
+    print_row("every pair:", naive_seconds, stop_count * (stop_count - 1) / 2, naive_pairs.size());
+    print_row("grid join:", join_stats.seconds, join_stats.compared_pairs, join_stats.found_pairs);
+    const bool pairs_match = GetSortedPairs(naive_pairs) == GetSortedPairs(grid_pairs);
+    std::cout << "  the grid join is x" << std::setprecision(1) << naive_seconds / join_stats.seconds << " faster, "
+              << (pairs_match ? "pairs match" : "[PAIRS DIFFER]") << std::endl;
+    return pairs_match ? 0 : 1;
+}
@@ -1,8 +1,31 @@
 #include "src/headers/request_handler.h"
 
-int main() {
-    Transportation::TransportCatalogue transp_cat;
+#include <string_view>
+
+using namespace std::literals;
+
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: TransportCatalogue [make_base|process_requests]\n"sv;
+}
+
+int main(int argc, char* argv[]) {
+    const std::string_view mode = argc > 1 ? std::string_view(argv[1]) : ""sv;
+    if (argc > 2 || (argc == 2 && mode != "make_base"sv && mode != "process_requests"sv)) {
+        PrintUsage();
+        return 1;
+    }
+
+    Transportation::CatalogueVersions transp_cat;
     RequestHandler req_handler(transp_cat);
     req_handler.ReadInput(std::cin);
-    req_handler.ProcessInput(std::cout);
+
+    if (mode == "make_base"sv) {
+        req_handler.MakeBase();
+    }
+    else if (mode == "process_requests"sv) {
+        req_handler.ProcessRequests(std::cout);
+    }
+    else { // base and stat requests in a single document
+        req_handler.ProcessInput(std::cout);
+    }
 }
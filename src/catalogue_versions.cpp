@@ -0,0 +1,193 @@
+#include "headers/catalogue_versions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace Transportation{
+
+CatalogueSnapshot::CatalogueSnapshot(detail::CatalogueVersion* version) noexcept : version_(version) {}
+
+CatalogueSnapshot::CatalogueSnapshot(const CatalogueSnapshot& other) noexcept : version_(other.version_){
+    if (version_){ // the other snapshot keeps the version alive meanwhile, so counting one more needs no ordering
+        version_->snapshot_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+CatalogueSnapshot::CatalogueSnapshot(CatalogueSnapshot&& other) noexcept : version_(std::exchange(other.version_, nullptr)) {}
+
+CatalogueSnapshot& CatalogueSnapshot::operator=(CatalogueSnapshot other) noexcept{
+    std::swap(version_, other.version_);
+    return *this;
+}
+
+CatalogueSnapshot::~CatalogueSnapshot(){
+    Release();
+}
+
+void CatalogueSnapshot::Release() noexcept{
+    if (version_){
+        // release: the reads of the version happen before a writer sees the count drop and frees it
+        version_->snapshot_count.fetch_sub(1, std::memory_order_release);
+        version_ = nullptr;
+    }
+}
+
+const TransportCatalogue& CatalogueSnapshot::operator*() const noexcept{
+    assert(version_);
+    return version_->catalogue;
+}
+
+const TransportCatalogue* CatalogueSnapshot::operator->() const noexcept{
+    assert(version_);
+    return &version_->catalogue;
+}
+
+uint64_t CatalogueSnapshot::GetVersion() const noexcept{
+    assert(version_);
+    return version_->number;
+}
+
+CatalogueSnapshot::operator bool() const noexcept{
+    return version_ != nullptr;
+}
+
+CatalogueVersions::CatalogueVersions() : CatalogueVersions(TransportCatalogue{}) {}
+
+CatalogueVersions::CatalogueVersions(TransportCatalogue&& catalogue){
+    catalogue.Finalize();
+    current_.store(new detail::CatalogueVersion{std::move(catalogue), 0});
+}
+
+CatalogueVersions::~CatalogueVersions(){
+    detail::CatalogueVersion* current = current_.load();
+    assert(current->snapshot_count.load() == 0);
+    delete current;
+    for (detail::CatalogueVersion* version : retired_){
+        assert(version->snapshot_count.load() == 0);
+        delete version;
+    }
+}
+
+CatalogueSnapshot CatalogueVersions::Acquire() const noexcept{
+    // The writer flipping the phase waits for the readers counted in the phase before. A reader counting itself in
+    // a phase flipped already may have been missed by that wait, so it counts itself in the new phase instead.
+    while (true){
+        const uint64_t phase = phase_.load();
+        std::atomic<size_t>& acquiring_count = acquiring_counts_[phase % 2];
+        acquiring_count.fetch_add(1);
+        if (phase_.load() == phase){
+            detail::CatalogueVersion* version = current_.load();
+            version->snapshot_count.fetch_add(1, std::memory_order_relaxed);
+            acquiring_count.fetch_sub(1, std::memory_order_release); // the snapshot is counted before the reader is seen gone
+            return CatalogueSnapshot(version);
+        }
+        acquiring_count.fetch_sub(1);
+    }
+}
+
+uint64_t CatalogueVersions::Publish(TransportCatalogue&& catalogue){
+    catalogue.Finalize(); // outside of the lock: it takes as long as sorting the stops and the buses
+    std::lock_guard guard(writers_mutex_);
+    return PublishLocked(std::move(catalogue));
+}
+
+uint64_t CatalogueVersions::PublishOver(uint64_t base_version, TransportCatalogue&& catalogue){
+    catalogue.Finalize();
+    std::lock_guard guard(writers_mutex_);
+    if (last_version_ != base_version){
+        throw std::logic_error("[!] Version " + std::to_string(last_version_) + " has been published since the builder started from version "
+                               + std::to_string(base_version) + ".");
+    }
+    return PublishLocked(std::move(catalogue));
+}
+
+uint64_t CatalogueVersions::PublishLocked(TransportCatalogue&& catalogue){
+    detail::CatalogueVersion* version = new detail::CatalogueVersion{std::move(catalogue), ++last_version_};
+    detail::CatalogueVersion* retired_version = current_.exchange(version);
+    retired_version->state = detail::CatalogueVersion::State::RETIRED;
+    retired_.push_back(retired_version);
+    ReclaimLocked();
+    return last_version_;
+}
+
+size_t CatalogueVersions::Reclaim(){
+    std::lock_guard guard(writers_mutex_);
+    return ReclaimLocked();
+}
+
+size_t CatalogueVersions::ReclaimLocked(){
+    using State = detail::CatalogueVersion::State;
+
+    FinishDraining();
+    // Readers loading the phase after the flip load current_ after the versions have been retired, so the versions
+    // retired so far wait only for the readers of the phase before. A single flip is waited for at a time.
+    if (!draining_phase_ && std::any_of(retired_.begin(), retired_.end(), [](auto* version){ return version->state == State::RETIRED; })){
+        for (detail::CatalogueVersion* version : retired_){
+            if (version->state == State::RETIRED){
+                version->state = State::DRAINING;
+            }
+        }
+        draining_phase_ = phase_.fetch_add(1);
+        FinishDraining(); // readers are quick to leave, they may well be gone already
+    }
+
+    const auto freed = std::remove_if(retired_.begin(), retired_.end(), [](detail::CatalogueVersion* version){
+        // acquire: the reads of the released snapshots happen before the version is freed
+        if (version->state == State::UNREACHABLE && version->snapshot_count.load(std::memory_order_acquire) == 0){
+            delete version;
+            return true;
+        }
+        return false;
+    });
+    const size_t freed_count = retired_.end() - freed;
+    retired_.erase(freed, retired_.end());
+    return freed_count;
+}
+
+void CatalogueVersions::FinishDraining(){
+    using State = detail::CatalogueVersion::State;
+
+    if (!draining_phase_ || acquiring_counts_[*draining_phase_ % 2].load() != 0){
+        return;
+    }
+    for (detail::CatalogueVersion* version : retired_){
+        if (version->state == State::DRAINING){
+            version->state = State::UNREACHABLE;
+        }
+    }
+    draining_phase_.reset();
+}
+
+size_t CatalogueVersions::GetVersionCount() const{
+    std::lock_guard guard(writers_mutex_);
+    return retired_.size() + 1;
+}
+
+CatalogueBuilder::CatalogueBuilder(CatalogueVersions& versions) : versions_(versions){
+    const CatalogueSnapshot snapshot = versions_.Acquire();
+    base_version_ = snapshot.GetVersion();
+    catalogue_ = std::make_unique<TransportCatalogue>(*snapshot);
+}
+
+TransportCatalogue& CatalogueBuilder::GetCatalogue(){
+    if (!catalogue_){
+        throw std::logic_error("[!] The builder has published its catalogue already.");
+    }
+    return *catalogue_;
+}
+
+uint64_t CatalogueBuilder::GetBaseVersion() const noexcept{
+    return base_version_;
+}
+
+uint64_t CatalogueBuilder::Publish(){
+    TransportCatalogue& catalogue = GetCatalogue();
+    const uint64_t version = versions_.PublishOver(base_version_, std::move(catalogue));
+    catalogue_.reset();
+    return version;
+}
+
+} // namespace Transportation
@@ -1,6 +1,7 @@
 #define _USE_MATH_DEFINES
 #include "headers/geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
@@ -11,9 +12,106 @@ double ComputeDistance(Coordinates from, Coordinates to) {
         return 0;
     }
     static const double dr = M_PI / 180.;
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+    // rounding may push the cosine of a tiny angle past 1
+    return acos(min(1.0, sin(from.lat * dr) * sin(to.lat * dr)
+                         + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr)))
+        * EARTH_RADIUS;
+}
+
+PreparedCoordinates PrepareCoordinates(Coordinates coordinates) {
+    static const double dr = M_PI / 180.;
+    return {std::sin(coordinates.lat * dr), std::cos(coordinates.lat * dr), std::sin(coordinates.lng * dr), std::cos(coordinates.lng * dr)};
+}
+
+namespace {
+
+// The cosine of the angle between two points, from the angle difference formula for the cosine of the longitude difference.
+inline double ComputeAngleCosine(double sin_lat_from, double cos_lat_from, double sin_lng_from, double cos_lng_from,
+                                 double sin_lat_to, double cos_lat_to, double sin_lng_to, double cos_lng_to) {
+    const double cos_lng_delta = cos_lng_from * cos_lng_to + sin_lng_from * sin_lng_to;
+    return std::min(1.0, sin_lat_from * sin_lat_to + cos_lat_from * cos_lat_to * cos_lng_delta);
+}
+
+// Rounding may make the cosine of the angle between a point and itself slightly less than 1, so such pairs are told apart.
+bool IsSamePoint(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+    return from.sin_lat == to.sin_lat && from.cos_lat == to.cos_lat && from.sin_lng == to.sin_lng && from.cos_lng == to.cos_lng;
+}
+
+#if defined(__GNUC__)
+// GCC and Clang vector extensions: arithmetic on a whole vector compiles to SIMD instructions of the target.
+using Lanes = double __attribute__((vector_size(sizeof(double) * DISTANCE_LANES)));
+#else
+struct Lanes {
+    double values[DISTANCE_LANES];
+
+    double& operator[](size_t lane) {
+        return values[lane];
+    }
+    double operator[](size_t lane) const {
+        return values[lane];
+    }
+    Lanes operator+(const Lanes& other) const {
+        Lanes result;
+        for (size_t lane = 0; lane < DISTANCE_LANES; ++lane) {
+            result.values[lane] = values[lane] + other.values[lane];
+        }
+        return result;
+    }
+    Lanes operator*(const Lanes& other) const {
+        Lanes result;
+        for (size_t lane = 0; lane < DISTANCE_LANES; ++lane) {
+            result.values[lane] = values[lane] * other.values[lane];
+        }
+        return result;
+    }
+};
+#endif
+
+// Prepared coordinates of DISTANCE_LANES points, a lane per point.
+struct CoordinateLanes {
+    Lanes sin_lat;
+    Lanes cos_lat;
+    Lanes sin_lng;
+    Lanes cos_lng;
+
+    void Set(size_t lane, const PreparedCoordinates& point) {
+        sin_lat[lane] = point.sin_lat;
+        cos_lat[lane] = point.cos_lat;
+        sin_lng[lane] = point.sin_lng;
+        cos_lng[lane] = point.cos_lng;
+    }
+};
+
+}  // namespace
+
+double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+    if (IsSamePoint(from, to)) {
+        return 0;
+    }
+    return std::acos(ComputeAngleCosine(from.sin_lat, from.cos_lat, from.sin_lng, from.cos_lng,
+                                        to.sin_lat, to.cos_lat, to.sin_lng, to.cos_lng)) * EARTH_RADIUS;
+}
+
+void ComputePathDistances(const PreparedCoordinates* points, const uint32_t* path, size_t path_size, double* distances) {
+    const size_t pair_count = path_size < 2 ? 0 : path_size - 1;
+    size_t pair = 0;
+    for (; pair + DISTANCE_LANES <= pair_count; pair += DISTANCE_LANES) {
+        CoordinateLanes from;
+        CoordinateLanes to;
+        for (size_t lane = 0; lane < DISTANCE_LANES; ++lane) {
+            from.Set(lane, points[path[pair + lane]]);
+            to.Set(lane, points[path[pair + lane + 1]]);
+        }
+        const Lanes cosines = from.sin_lat * to.sin_lat + from.cos_lat * to.cos_lat * (from.cos_lng * to.cos_lng + from.sin_lng * to.sin_lng);
+        for (size_t lane = 0; lane < DISTANCE_LANES; ++lane) {
+            // the arc cosine is left to the library, lane by lane
+            distances[pair + lane] = IsSamePoint(points[path[pair + lane]], points[path[pair + lane + 1]])
+                                     ? 0.0 : std::acos(std::min(1.0, cosines[lane])) * EARTH_RADIUS;
+        }
+    }
+    for (; pair < pair_count; ++pair) {
+        distances[pair] = ComputeDistance(points[path[pair]], points[path[pair + 1]]);
+    }
 }
 
 size_t CoordinatesHasher::operator()(const Coordinates& coords) const noexcept{
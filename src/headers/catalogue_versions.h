@@ -0,0 +1,154 @@
+// This file contains versions of the catalogue published for concurrent readers
+
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Transportation{
+
+namespace detail{
+    // A published catalogue. It is never modified, and lives as long as it is current or held by some snapshot.
+    struct CatalogueVersion{
+        TransportCatalogue catalogue;
+        uint64_t number = 0;
+        std::atomic<size_t> snapshot_count{0};
+        // guarded by the writers' mutex
+        enum class State{
+            CURRENT,
+            RETIRED,
+            DRAINING, // retired before the phase flip being waited for
+            UNREACHABLE // no reader can be about to take a snapshot of it anymore
+        } state = State::CURRENT;
+    };
+} // namespace detail
+
+// A reader's handle to a published version of the catalogue. The version stays valid, and unchanged, as long as
+// the snapshot holds it, however many versions get published meanwhile. Copying a snapshot shares the version.
+class CatalogueSnapshot{
+public: // --------- CONSTRUCTORS ---------
+    CatalogueSnapshot() = default;
+    CatalogueSnapshot(const CatalogueSnapshot& other) noexcept;
+    CatalogueSnapshot(CatalogueSnapshot&& other) noexcept;
+    CatalogueSnapshot& operator=(CatalogueSnapshot other) noexcept;
+    ~CatalogueSnapshot();
+
+public: // --------- METHODS ---------
+    const TransportCatalogue& operator*() const noexcept;
+    const TransportCatalogue* operator->() const noexcept;
+
+    // The number Publish has given the version, 0 for the first one.
+    uint64_t GetVersion() const noexcept;
+
+    // Whether the snapshot holds a version: default-constructed and moved-from ones don't.
+    explicit operator bool() const noexcept;
+
+    // Lets the version go, so it can be reclaimed once no other snapshot holds it.
+    void Release() noexcept;
+
+private:
+    friend class CatalogueVersions;
+    explicit CatalogueSnapshot(detail::CatalogueVersion* version) noexcept;
+
+    detail::CatalogueVersion* version_ = nullptr;
+};
+
+// Versions of the catalogue, for readers to query while the next versions are being prepared and published.
+// Readers never block: taking a snapshot is a few atomic operations, waiting neither for writers nor for other readers,
+// and taken again only if a writer flips the phase, see below, right in between.
+// Writers swap the next version in atomically, and free the retired ones once no snapshot holds them, in the manner of RCU:
+// a retired version can't be freed while some reader may have loaded it without counting its snapshot yet, so readers
+// announce themselves in the counter of the current phase, and writers flip the phase and wait for the counter of the
+// previous one to drain. New readers go to the other counter, so a steady stream of them doesn't hold reclamation back.
+class CatalogueVersions{
+public: // --------- CONSTRUCTORS ---------
+    // Starts with an empty catalogue as version 0.
+    CatalogueVersions();
+    // Starts with `catalogue`, finalized, as version 0.
+    explicit CatalogueVersions(TransportCatalogue&& catalogue);
+
+    CatalogueVersions(const CatalogueVersions&) = delete;
+    CatalogueVersions& operator=(const CatalogueVersions&) = delete;
+
+    // Snapshots must not outlive the versions.
+    ~CatalogueVersions();
+
+public: // --------- METHODS ---------
+    // Takes a snapshot of the current version. Safe to call from any number of threads, concurrently with Publish.
+    CatalogueSnapshot Acquire() const noexcept;
+
+    /** Makes a catalogue the current version. Snapshots taken before go on reading the versions they hold.
+     * @param catalogue The next version. It is finalized if it hasn't been.
+     * @returns The number of the version.
+    */
+    uint64_t Publish(TransportCatalogue&& catalogue);
+
+    /** Frees the retired versions no snapshot holds anymore. Publish calls it too, so calling it is only needed to free
+     * versions released since the last Publish.
+     * @returns How many versions have been freed.
+    */
+    size_t Reclaim();
+
+    // Versions in memory: the current one, and the retired ones not reclaimed yet.
+    size_t GetVersionCount() const;
+
+private: // --------- HELPER METHODS ---------
+    friend class CatalogueBuilder;
+
+    // Publishes `catalogue` unless a version after `base_version` has been published: the changes made to a copy of
+    // the base version would drop those of the later one.
+    uint64_t PublishOver(uint64_t base_version, TransportCatalogue&& catalogue);
+
+    uint64_t PublishLocked(TransportCatalogue&& catalogue);
+    size_t ReclaimLocked();
+
+    // Marks the draining versions unreachable if no reader of the phase they wait for is left.
+    void FinishDraining();
+
+private: // --------- FIELDS ---------
+    std::atomic<detail::CatalogueVersion*> current_;
+    mutable std::atomic<uint64_t> phase_{0};
+    // readers between loading current_ and counting their snapshot in the version loaded, by the parity of their phase
+    mutable std::atomic<size_t> acquiring_counts_[2] = {0, 0};
+
+    mutable std::mutex writers_mutex_; // guards the fields below
+    std::vector<detail::CatalogueVersion*> retired_;
+    std::optional<uint64_t> draining_phase_; // the phase whose readers the draining versions wait for
+    uint64_t last_version_ = 0;
+};
+
+// Prepares the next version of the catalogue aside from the published ones, starting from a copy of the current version.
+// Readers go on with the current version until Publish swaps the prepared one in.
+class CatalogueBuilder{
+public: // --------- CONSTRUCTORS ---------
+    explicit CatalogueBuilder(CatalogueVersions& versions);
+
+public: // --------- METHODS ---------
+    // The catalogue being prepared, to add stops, buses and distances to. Only the builder's thread may use it.
+    // It is not finalized, so its indices are built once, by Publish, however many stops and buses get added.
+    TransportCatalogue& GetCatalogue();
+
+    // The number of the version the builder has started from.
+    uint64_t GetBaseVersion() const noexcept;
+
+    /** Publishes the prepared catalogue. The builder can't be used afterwards.
+     * @returns The number of the published version.
+     * @throws std::logic_error if another version has been published since the builder started: the builder would
+     * drop its changes. Start another builder from the new version and apply the changes again.
+    */
+    uint64_t Publish();
+
+private: // --------- FIELDS ---------
+    CatalogueVersions& versions_;
+    uint64_t base_version_;
+    std::unique_ptr<TransportCatalogue> catalogue_;
+};
+
+} // namespace Transportation
@@ -0,0 +1,550 @@
+// This file contains a contraction hierarchy implementation of the graph router
+
+#pragma once
+
+#include "router.h"
+#include "search_space.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Vertices are contracted one by one in the order of their importance, while shortcut edges preserve the lightest
+// routes between the remaining ones. Queries then search only "upwards" in the hierarchy from both ends of a route
+// and settle a tiny fraction of the graph. Query buffers are kept between queries (not thread-safe).
+template <typename Weight>
+class ContractionHierarchyRouter : public RouterBase<Weight> {
+private:
+    using Graph = CsrGraph<Weight>;
+
+public: // --------- MAIN PUBLIC API ---------
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    // A single search over the graph's own edges, cut off at `max_weight`: shortcuts only pay off between two given ends,
+    // while all of the vertices within reach have to be settled anyway.
+    std::vector<std::pair<VertexId, Weight>> ComputeReachableVertices(VertexId from, Weight max_weight) const override;
+
+    std::vector<std::optional<Weight>> ComputeRouteWeights(VertexId from, const std::vector<VertexId>& to) const override {
+        return ComputeRouteWeightMatrix({from}, to).front();
+    }
+
+    // Many-to-many search with buckets: an upward search from every target leaves its weights in buckets of the vertices
+    // it settles, then an upward search from every source meets them there. Routes are not unpacked.
+    std::vector<std::vector<std::optional<Weight>>> ComputeRouteWeightMatrix(const std::vector<VertexId>& from,
+                                                                             const std::vector<VertexId>& to) const override;
+
+    size_t GetVertexCount() const override {
+        return vertex_count_;
+    }
+
+    size_t GetSettledCount() const override {
+        return forward_.GetSettledCount() + backward_.GetSettledCount();
+    }
+
+    // Number of shortcut edges added by the preprocessing.
+    size_t GetShortcutCount() const {
+        return edges_.size() - original_edge_count_;
+    }
+
+private: // --------- HELPER TYPES ---------
+    static constexpr size_t NO_EDGE = std::numeric_limits<size_t>::max();
+    // Witness searches are cut off after settling this many vertices; a shortcut is added if no witness is found by then.
+    static constexpr size_t WITNESS_SEARCH_LIMIT = 100;
+
+    // An edge of the hierarchy. The first edges are the graph's ones (with the same ids), the rest are shortcuts
+    // over contracted vertices, each made of two hierarchy edges.
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        size_t first_half = NO_EDGE;
+        size_t second_half = NO_EDGE;
+    };
+
+    // An adjacency entry: a neighbouring vertex and the hierarchy edge leading to (or from) it.
+    struct Arc {
+        VertexId vertex;
+        size_t edge;
+    };
+
+    // Temporary data of the preprocessing.
+    struct ContractionState {
+        std::vector<std::vector<Arc>> out_arcs;
+        std::vector<std::vector<Arc>> in_arcs;
+        std::vector<bool> contracted;
+        std::vector<int64_t> contracted_neighbours;
+        SearchSpace<Weight> witness_search;
+        std::vector<std::optional<Weight>> witness_targets; // weights of shortcuts to the targets of the running witness search
+    };
+
+private: // --------- HELPER METHODS ---------
+    // Contracts all vertices in the order of their priority and stores the resulting ranks.
+    void ContractGraph();
+
+    /** Finds shortcuts needed to contract `vertex`.
+     * @param simulate If true, only counts the shortcuts without adding them.
+     * @returns The number of shortcuts.
+    */
+    int64_t ProcessVertex(ContractionState& state, VertexId vertex, bool simulate);
+
+    // Contraction priority: the (shortcut-weighted) edge difference plus the number of already contracted neighbours.
+    int64_t ComputePriority(ContractionState& state, VertexId vertex);
+
+    // Removes arcs to `vertex` from an adjacency list.
+    static void DetachArcs(std::vector<Arc>& arcs, VertexId vertex) {
+        arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [vertex](const Arc& arc) { return arc.vertex == vertex; }), arcs.end());
+    }
+
+    // Lightest arcs to every distinct uncontracted neighbour, except `excluded`.
+    std::vector<Arc> GetLightestArcs(const ContractionState& state, const std::vector<Arc>& arcs, VertexId excluded) const;
+
+    /** Runs a bounded search from `source` that avoids `excluded` vertex, until all `targets` are reached
+     * by routes at least as light as the shortcuts through `excluded` would be.
+     * @param source_weight Weight of the edge between `source` and `excluded`.
+     * @param backward If true, searches along incoming edges.
+    */
+    void RunWitnessSearch(ContractionState& state, const Arc& source, VertexId excluded, const std::vector<Arc>& targets,
+                          bool backward) const;
+
+    // Packs the edges going up the hierarchy into per-vertex adjacency arrays of both search directions.
+    void BuildUpwardGraph();
+
+    /** Runs a search up the hierarchy, as far as it goes, and calls `visit(vertex, weight)` for every vertex it settles.
+     * @param backward If true, searches from a target along the edges coming down to it, in the backward search space.
+    */
+    template <typename Visit>
+    void RunUpwardSearch(VertexId source, bool backward, Visit visit) const;
+
+    // Expands a hierarchy edge into the graph's edges and appends them to `edges`.
+    void UnpackEdge(size_t hierarchy_edge, std::vector<EdgeId>& edges) const;
+
+private: // --------- FIELDS ---------
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_; // the routers are rebuilt along with the graph, so it outlives them
+    const size_t vertex_count_;
+    const size_t original_edge_count_;
+
+    std::vector<HierarchyEdge> edges_;
+    std::vector<size_t> rank_;
+
+    // Edges to higher ranked vertices (forward search) and from higher ranked vertices (backward search).
+    std::vector<size_t> upward_offsets_;
+    std::vector<Arc> upward_arcs_;
+    std::vector<size_t> downward_offsets_;
+    std::vector<Arc> downward_arcs_;
+
+    mutable SearchSpace<Weight> forward_;
+    mutable SearchSpace<Weight> backward_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , original_edge_count_(graph.GetEdgeCount())
+    , forward_(graph.GetVertexCount())
+    , backward_(graph.GetVertexCount())
+{
+    edges_.reserve(original_edge_count_ * 2);
+    for (EdgeId edge_id = 0; edge_id < original_edge_count_; ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        // removed edges keep their index as self-loops, which are neither contracted nor searched
+        edges_.push_back({edge.from, graph.IsEdgeRemoved(edge_id) ? edge.from : edge.to, edge.weight});
+    }
+
+    ContractGraph();
+    BuildUpwardGraph();
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::ContractGraph() {
+    ContractionState state{
+        std::vector<std::vector<Arc>>(vertex_count_),
+        std::vector<std::vector<Arc>>(vertex_count_),
+        std::vector<bool>(vertex_count_, false),
+        std::vector<int64_t>(vertex_count_, 0),
+        SearchSpace<Weight>(vertex_count_),
+        std::vector<std::optional<Weight>>(vertex_count_)
+    };
+    for (size_t edge_index = 0; edge_index < edges_.size(); ++edge_index) {
+        const HierarchyEdge& edge = edges_[edge_index];
+        if (edge.from != edge.to) {
+            state.out_arcs[edge.from].push_back({edge.to, edge_index});
+            state.in_arcs[edge.to].push_back({edge.from, edge_index});
+        }
+    }
+
+    using QueueEntry = std::pair<int64_t, VertexId>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        queue.push({ComputePriority(state, vertex), vertex});
+    }
+
+    rank_.assign(vertex_count_, 0);
+    size_t next_rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+
+        // Priorities change as neighbours get contracted, so they are refreshed lazily
+        const int64_t priority = ComputePriority(state, vertex);
+        if (!queue.empty() && priority > queue.top().first) {
+            queue.push({priority, vertex});
+            continue;
+        }
+
+        ProcessVertex(state, vertex, false);
+        state.contracted[vertex] = true;
+        rank_[vertex] = next_rank++;
+        for (const Arc& arc : state.out_arcs[vertex]) { // detach the vertex, so that searches do not scan its arcs anymore
+            ++state.contracted_neighbours[arc.vertex];
+            DetachArcs(state.in_arcs[arc.vertex], vertex);
+        }
+        for (const Arc& arc : state.in_arcs[vertex]) {
+            ++state.contracted_neighbours[arc.vertex];
+            DetachArcs(state.out_arcs[arc.vertex], vertex);
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchyRouter<Weight>::Arc>
+ContractionHierarchyRouter<Weight>::GetLightestArcs(const ContractionState& state, const std::vector<Arc>& arcs,
+                                                    VertexId excluded) const {
+    std::vector<Arc> lightest_arcs;
+    lightest_arcs.reserve(arcs.size());
+    for (const Arc& arc : arcs) {
+        if (arc.vertex != excluded && !state.contracted[arc.vertex]) {
+            lightest_arcs.push_back(arc);
+        }
+    }
+    // Parallel edges of equal weight are resolved in favour of the lowest edge id, like Router does
+    std::sort(lightest_arcs.begin(), lightest_arcs.end(), [this](const Arc& left, const Arc& right) {
+        if (left.vertex != right.vertex) {
+            return left.vertex < right.vertex;
+        }
+        if (edges_[left.edge].weight < edges_[right.edge].weight || edges_[right.edge].weight < edges_[left.edge].weight) {
+            return edges_[left.edge].weight < edges_[right.edge].weight;
+        }
+        return left.edge < right.edge;
+    });
+    lightest_arcs.erase(std::unique(lightest_arcs.begin(), lightest_arcs.end(), [](const Arc& left, const Arc& right) {
+        return left.vertex == right.vertex;
+    }), lightest_arcs.end());
+    return lightest_arcs;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::RunWitnessSearch(ContractionState& state, const Arc& source, VertexId excluded,
+                                                          const std::vector<Arc>& targets, bool backward) const {
+    const Weight source_weight = edges_[source.edge].weight;
+    Weight max_weight = ZERO_WEIGHT;
+    size_t targets_left = 0;
+    for (const Arc& target : targets) {
+        if (target.vertex != source.vertex) {
+            const Weight shortcut_weight = source_weight + edges_[target.edge].weight;
+            state.witness_targets[target.vertex] = shortcut_weight;
+            max_weight = std::max(max_weight, shortcut_weight);
+            ++targets_left;
+        }
+    }
+
+    SearchSpace<Weight>& search = state.witness_search;
+    search.Reset();
+    search.Reach(source.vertex, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+
+    while (targets_left > 0 && search.HasNext() && search.GetSettledCount() < WITNESS_SEARCH_LIMIT) {
+        if (max_weight < search.PeekKey()) {
+            break;
+        }
+        const VertexId vertex = search.SettleNext();
+        const Weight vertex_weight = search.GetWeight(vertex);
+        for (const Arc& arc : backward ? state.in_arcs[vertex] : state.out_arcs[vertex]) {
+            if (arc.vertex == excluded || state.contracted[arc.vertex]) {
+                continue;
+            }
+            const Weight weight = vertex_weight + edges_[arc.edge].weight;
+            if (search.Relax(arc.vertex, weight, ZERO_WEIGHT, std::nullopt)) {
+                std::optional<Weight>& target = state.witness_targets[arc.vertex];
+                if (target && !(*target < weight)) { // a witness is found, the target needs no shortcut
+                    target.reset();
+                    --targets_left;
+                }
+            }
+        }
+    }
+
+    for (const Arc& target : targets) {
+        state.witness_targets[target.vertex].reset();
+    }
+}
+
+template <typename Weight>
+int64_t ContractionHierarchyRouter<Weight>::ProcessVertex(ContractionState& state, VertexId vertex, bool simulate) {
+    const std::vector<Arc> in_arcs = GetLightestArcs(state, state.in_arcs[vertex], vertex);
+    const std::vector<Arc> out_arcs = GetLightestArcs(state, state.out_arcs[vertex], vertex);
+    if (in_arcs.empty() || out_arcs.empty()) {
+        return 0;
+    }
+
+    // Witness searches are run from the side with fewer neighbours: forward from every
+    // in-neighbour, or backward from every out-neighbour.
+    const bool backward = out_arcs.size() < in_arcs.size();
+    const std::vector<Arc>& sources = backward ? out_arcs : in_arcs;
+    const std::vector<Arc>& targets = backward ? in_arcs : out_arcs;
+
+    int64_t shortcut_count = 0;
+    for (const Arc& source : sources) {
+        const Weight source_weight = edges_[source.edge].weight;
+        RunWitnessSearch(state, source, vertex, targets, backward);
+
+        for (const Arc& target : targets) {
+            if (target.vertex == source.vertex) {
+                continue;
+            }
+            const Weight shortcut_weight = source_weight + edges_[target.edge].weight;
+            if (state.witness_search.IsReached(target.vertex) && !(shortcut_weight < state.witness_search.GetWeight(target.vertex))) {
+                continue; // there is a route at least as light that avoids the vertex
+            }
+
+            ++shortcut_count;
+            if (!simulate) {
+                const Arc& in_arc = backward ? target : source;
+                const Arc& out_arc = backward ? source : target;
+                edges_.push_back({in_arc.vertex, out_arc.vertex, shortcut_weight, in_arc.edge, out_arc.edge});
+                state.out_arcs[in_arc.vertex].push_back({out_arc.vertex, edges_.size() - 1});
+                state.in_arcs[out_arc.vertex].push_back({in_arc.vertex, edges_.size() - 1});
+            }
+        }
+    }
+    return shortcut_count;
+}
+
+template <typename Weight>
+int64_t ContractionHierarchyRouter<Weight>::ComputePriority(ContractionState& state, VertexId vertex) {
+    int64_t removed_edge_count = 0;
+    for (const Arc& arc : state.out_arcs[vertex]) {
+        removed_edge_count += !state.contracted[arc.vertex];
+    }
+    for (const Arc& arc : state.in_arcs[vertex]) {
+        removed_edge_count += !state.contracted[arc.vertex];
+    }
+    return 2 * ProcessVertex(state, vertex, true) - removed_edge_count + state.contracted_neighbours[vertex];
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::BuildUpwardGraph() {
+    upward_offsets_.assign(vertex_count_ + 1, 0);
+    downward_offsets_.assign(vertex_count_ + 1, 0);
+    for (const HierarchyEdge& edge : edges_) {
+        if (rank_[edge.from] < rank_[edge.to]) {
+            ++upward_offsets_[edge.from + 1];
+        }
+        else if (rank_[edge.to] < rank_[edge.from]) {
+            ++downward_offsets_[edge.to + 1];
+        }
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        upward_offsets_[vertex + 1] += upward_offsets_[vertex];
+        downward_offsets_[vertex + 1] += downward_offsets_[vertex];
+    }
+
+    upward_arcs_.resize(upward_offsets_.back());
+    downward_arcs_.resize(downward_offsets_.back());
+    std::vector<size_t> upward_positions(upward_offsets_.begin(), upward_offsets_.end() - 1);
+    std::vector<size_t> downward_positions(downward_offsets_.begin(), downward_offsets_.end() - 1);
+    for (size_t edge_index = 0; edge_index < edges_.size(); ++edge_index) {
+        const HierarchyEdge& edge = edges_[edge_index];
+        if (rank_[edge.from] < rank_[edge.to]) {
+            upward_arcs_[upward_positions[edge.from]++] = {edge.to, edge_index};
+        }
+        else if (rank_[edge.to] < rank_[edge.from]) {
+            downward_arcs_[downward_positions[edge.to]++] = {edge.from, edge_index};
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(size_t hierarchy_edge, std::vector<EdgeId>& edges) const {
+    std::vector<size_t> stack{hierarchy_edge};
+    while (!stack.empty()) {
+        const size_t edge_index = stack.back();
+        stack.pop_back();
+        if (edge_index < original_edge_count_) {
+            edges.push_back(edge_index);
+            continue;
+        }
+        stack.push_back(edges_[edge_index].second_half);
+        stack.push_back(edges_[edge_index].first_half);
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+    forward_.Reset();
+    backward_.Reset();
+    forward_.Reach(from, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+    backward_.Reach(to, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+
+    std::optional<VertexId> meeting_vertex;
+    Weight best_weight{};
+    const auto try_meeting = [&](VertexId vertex) {
+        if (forward_.IsReached(vertex) && backward_.IsReached(vertex)) {
+            const Weight route_weight = forward_.GetWeight(vertex) + backward_.GetWeight(vertex);
+            if (!meeting_vertex || route_weight < best_weight) {
+                meeting_vertex = vertex;
+                best_weight = route_weight;
+            }
+        }
+    };
+    try_meeting(from);
+
+    // Both searches only go upwards, so each of them goes on until its lightest queued vertex is heavier than the best route
+    while (true) {
+        const bool forward_active = forward_.HasNext() && (!meeting_vertex || forward_.PeekKey() < best_weight);
+        const bool backward_active = backward_.HasNext() && (!meeting_vertex || backward_.PeekKey() < best_weight);
+        if (!forward_active && !backward_active) {
+            break;
+        }
+
+        const bool is_forward = forward_active && (!backward_active || !(backward_.PeekKey() < forward_.PeekKey()));
+        SearchSpace<Weight>& space = is_forward ? forward_ : backward_;
+        const std::vector<size_t>& offsets = is_forward ? upward_offsets_ : downward_offsets_;
+        const std::vector<Arc>& arcs = is_forward ? upward_arcs_ : downward_arcs_;
+
+        const VertexId vertex = space.SettleNext();
+        const Weight vertex_weight = space.GetWeight(vertex);
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const Arc& arc = arcs[i];
+            if (space.Relax(arc.vertex, vertex_weight + edges_[arc.edge].weight, ZERO_WEIGHT, arc.edge)) {
+                try_meeting(arc.vertex);
+            }
+        }
+    }
+
+    if (!meeting_vertex) {
+        return std::nullopt;
+    }
+
+    std::vector<size_t> forward_path;
+    for (std::optional<EdgeId> edge_index = forward_.GetPrevEdge(*meeting_vertex);
+         edge_index;
+         edge_index = forward_.GetPrevEdge(edges_[*edge_index].from))
+    {
+        forward_path.push_back(*edge_index);
+    }
+    std::vector<EdgeId> edges;
+    for (auto it = forward_path.rbegin(); it != forward_path.rend(); ++it) {
+        UnpackEdge(*it, edges);
+    }
+    for (std::optional<EdgeId> edge_index = backward_.GetPrevEdge(*meeting_vertex);
+         edge_index;
+         edge_index = backward_.GetPrevEdge(edges_[*edge_index].to))
+    {
+        UnpackEdge(*edge_index, edges);
+    }
+
+    return RouteInfo{forward_.GetWeight(*meeting_vertex) + backward_.GetWeight(*meeting_vertex), std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> ContractionHierarchyRouter<Weight>::ComputeReachableVertices(VertexId from,
+                                                                                                     Weight max_weight) const {
+    if (from >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+    forward_.Reset();
+    backward_.Reset();
+    forward_.Reach(from, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    while (forward_.HasNext() && !(max_weight < forward_.PeekKey())) { // vertices are settled by weight, so the rest are even farther
+        const VertexId vertex = forward_.SettleNext();
+        const Weight vertex_weight = forward_.GetWeight(vertex);
+        reachable.emplace_back(vertex, vertex_weight);
+        for (const graph::Arc<Weight>& arc : graph_.GetOutgoingArcs(vertex)) {
+            forward_.Relax(arc.vertex, vertex_weight + arc.weight, ZERO_WEIGHT, arc.edge_id);
+        }
+    }
+    return reachable;
+}
+
+template <typename Weight>
+template <typename Visit>
+void ContractionHierarchyRouter<Weight>::RunUpwardSearch(VertexId source, bool backward, Visit visit) const {
+    SearchSpace<Weight>& space = backward ? backward_ : forward_;
+    const std::vector<size_t>& offsets = backward ? downward_offsets_ : upward_offsets_;
+    const std::vector<Arc>& arcs = backward ? downward_arcs_ : upward_arcs_;
+    space.Reset();
+    space.Reach(source, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+    while (space.HasNext()) {
+        const VertexId vertex = space.SettleNext();
+        const Weight vertex_weight = space.GetWeight(vertex);
+        visit(vertex, vertex_weight);
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            space.Relax(arcs[i].vertex, vertex_weight + edges_[arcs[i].edge].weight, ZERO_WEIGHT, arcs[i].edge);
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<std::vector<std::optional<Weight>>>
+ContractionHierarchyRouter<Weight>::ComputeRouteWeightMatrix(const std::vector<VertexId>& from, const std::vector<VertexId>& to) const {
+    const auto is_out_of_range = [this](VertexId vertex) { return vertex >= vertex_count_; };
+    if (std::any_of(from.begin(), from.end(), is_out_of_range) || std::any_of(to.begin(), to.end(), is_out_of_range)) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+
+    // The lightest route is the lightest one over the vertices both upward searches of its ends settle
+    struct BucketEntry {
+        VertexId vertex;
+        size_t target;
+        Weight weight;
+    };
+    std::vector<BucketEntry> buckets;
+    for (size_t target = 0; target < to.size(); ++target) {
+        RunUpwardSearch(to[target], true, [&](VertexId vertex, Weight weight) {
+            buckets.push_back({vertex, target, weight});
+        });
+    }
+    std::sort(buckets.begin(), buckets.end(), [](const BucketEntry& lhs, const BucketEntry& rhs) { return lhs.vertex < rhs.vertex; });
+
+    std::vector<std::vector<std::optional<Weight>>> matrix;
+    matrix.reserve(from.size());
+    for (const VertexId source : from) {
+        std::vector<std::optional<Weight>>& row = matrix.emplace_back(to.size());
+        RunUpwardSearch(source, false, [&](VertexId vertex, Weight weight) {
+            auto entry = std::lower_bound(buckets.begin(), buckets.end(), vertex, [](const BucketEntry& lhs, VertexId rhs) {
+                return lhs.vertex < rhs;
+            });
+            for (; entry != buckets.end() && entry->vertex == vertex; ++entry) {
+                std::optional<Weight>& route_weight = row[entry->target];
+                if (!route_weight || weight + entry->weight < *route_weight) {
+                    route_weight = weight + entry->weight;
+                }
+            }
+        });
+    }
+    return matrix;
+}
+
+}  // namespace graph
@@ -0,0 +1,305 @@
+// This file contains an on-demand (single-source Dijkstra) implementation of the graph router
+
+#pragma once
+
+#include "router.h"
+#include "search_space.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+enum class SearchMode {
+    DIJKSTRA, // plain single-source search
+    A_STAR, // goal-directed search, guided by a lower bound of the remaining route weight
+    BIDIRECTIONAL // simultaneous searches from both ends of a route
+};
+
+// Routes are searched at query time, so memory grows with the number of edges instead of V^2.
+// Search buffers are kept between queries, which makes a single instance not thread-safe.
+template <typename Weight>
+class DijkstraRouter : public RouterBase<Weight> {
+private:
+    using Graph = CsrGraph<Weight>;
+
+public: // --------- MAIN PUBLIC API ---------
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    // A lower bound of the route weight from one vertex to another. It has to be consistent
+    // (potential(u, t) <= weight(u, v) + potential(v, t)) for A* to find the lightest routes.
+    using Potential = std::function<Weight(VertexId from, VertexId to)>;
+
+    /**
+     * @param graph A graph to search routes on.
+     * @param mode A search algorithm.
+     * @param potential A lower bound of route weights. Required for SearchMode::A_STAR only.
+    */
+    explicit DijkstraRouter(const Graph& graph, SearchMode mode = SearchMode::DIJKSTRA, Potential potential = nullptr);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    size_t GetVertexCount() const override {
+        return forward_.GetVertexCount();
+    }
+
+    // Runs a single plain search from `from` until all of `to` are settled, whatever the search mode is.
+    std::vector<std::optional<Weight>> ComputeRouteWeights(VertexId from, const std::vector<VertexId>& to) const override;
+
+    // Runs a single plain search from `from`, stopping at the first vertex farther than `max_weight`.
+    std::vector<std::pair<VertexId, Weight>> ComputeReachableVertices(VertexId from, Weight max_weight) const override;
+
+    // Runs a single plain search from `from` over the whole reachable part of the graph, whatever the search mode is.
+    std::optional<ShortestPathTree<Weight>> BuildShortestPathTree(VertexId from) const override;
+
+    size_t GetSettledCount() const override {
+        return forward_.GetSettledCount() + backward_.GetSettledCount();
+    }
+
+    // Nothing is precomputed, so only the search buffers may need to grow.
+    bool UpdateEdges(const std::vector<EdgeId>& added_edges, const std::vector<EdgeId>& removed_edges) override;
+
+private: // --------- HELPER METHODS ---------
+    // Runs the search from `from` until `is_done` holds for a settled vertex or the reachable part of the graph is exhausted.
+    // `goal` directs A* searches.
+    template <typename IsDone>
+    void RunSearch(VertexId from, std::optional<VertexId> goal, IsDone is_done) const;
+
+    // Runs searches from `from` and `to` until they meet on the lightest route. Returns the meeting vertex.
+    std::optional<VertexId> RunBidirectionalSearch(VertexId from, VertexId to) const;
+
+    // Collects edges leading to `vertex` in the forward search tree.
+    std::vector<EdgeId> UnpackForwardPath(VertexId vertex) const;
+
+private: // --------- FIELDS ---------
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    const SearchMode mode_;
+    const Potential potential_;
+
+    mutable SearchSpace<Weight> forward_;
+    mutable SearchSpace<Weight> backward_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph, SearchMode mode, Potential potential)
+    : graph_(graph)
+    , mode_(mode)
+    , potential_(std::move(potential))
+{
+    if (mode_ == SearchMode::A_STAR && !potential_) {
+        throw std::invalid_argument("A* search requires a potential function");
+    }
+
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+
+    forward_.Resize(vertex_count);
+    if (mode_ == SearchMode::BIDIRECTIONAL) {
+        backward_.Resize(vertex_count);
+    }
+}
+
+template <typename Weight>
+bool DijkstraRouter<Weight>::UpdateEdges(const std::vector<EdgeId>& added_edges, const std::vector<EdgeId>& /*removed_edges*/) {
+    for (const EdgeId edge_id : added_edges) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (forward_.GetVertexCount() != vertex_count) {
+        forward_.Resize(vertex_count);
+        if (mode_ == SearchMode::BIDIRECTIONAL) {
+            backward_.Resize(vertex_count);
+        }
+    }
+    return true;
+}
+
+template <typename Weight>
+template <typename IsDone>
+void DijkstraRouter<Weight>::RunSearch(VertexId from, std::optional<VertexId> goal, IsDone is_done) const {
+    const bool goal_directed = mode_ == SearchMode::A_STAR && goal;
+    forward_.Reach(from, ZERO_WEIGHT, goal_directed ? potential_(from, *goal) : ZERO_WEIGHT, std::nullopt);
+
+    while (forward_.HasNext()) {
+        const VertexId vertex = forward_.SettleNext();
+        if (is_done(vertex)) {
+            return;
+        }
+
+        const Weight vertex_weight = forward_.GetWeight(vertex);
+        for (const Arc<Weight>& arc : graph_.GetOutgoingArcs(vertex)) {
+            const Weight candidate_weight = vertex_weight + arc.weight;
+            if (!forward_.IsReached(arc.vertex)) {
+                forward_.Reach(arc.vertex, candidate_weight, goal_directed ? potential_(arc.vertex, *goal) : ZERO_WEIGHT, arc.edge_id);
+            }
+            else {
+                forward_.Relax(arc.vertex, candidate_weight, forward_.GetPotential(arc.vertex), arc.edge_id);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<VertexId> DijkstraRouter<Weight>::RunBidirectionalSearch(VertexId from, VertexId to) const {
+    forward_.Reach(from, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+    backward_.Reach(to, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+    if (from == to) {
+        return from;
+    }
+
+    std::optional<VertexId> meeting_vertex;
+    Weight best_weight{};
+
+    while (forward_.HasNext() && backward_.HasNext()) {
+        const Weight forward_key = forward_.PeekKey();
+        const Weight backward_key = backward_.PeekKey();
+        if (meeting_vertex && !(forward_key + backward_key < best_weight)) {
+            break; // no route through unsettled vertices can be lighter than the found one
+        }
+
+        const bool is_forward = !(backward_key < forward_key);
+        SearchSpace<Weight>& space = is_forward ? forward_ : backward_;
+        const SearchSpace<Weight>& opposite_space = is_forward ? backward_ : forward_;
+
+        const VertexId vertex = space.SettleNext();
+        const Weight vertex_weight = space.GetWeight(vertex);
+
+        for (const Arc<Weight>& arc : is_forward ? graph_.GetOutgoingArcs(vertex) : graph_.GetIncomingArcs(vertex)) {
+            space.Relax(arc.vertex, vertex_weight + arc.weight, ZERO_WEIGHT, arc.edge_id);
+            if (opposite_space.IsReached(arc.vertex)) {
+                const Weight route_weight = space.GetWeight(arc.vertex) + opposite_space.GetWeight(arc.vertex);
+                if (!meeting_vertex || route_weight < best_weight) {
+                    meeting_vertex = arc.vertex;
+                    best_weight = route_weight;
+                }
+            }
+        }
+    }
+    return meeting_vertex;
+}
+
+template <typename Weight>
+std::vector<EdgeId> DijkstraRouter<Weight>::UnpackForwardPath(VertexId vertex) const {
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = forward_.GetPrevEdge(vertex);
+         edge_id;
+         edge_id = forward_.GetPrevEdge(graph_.GetEdge(*edge_id).from))
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    if (from >= forward_.GetVertexCount() || to >= forward_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+    forward_.Reset();
+    backward_.Reset();
+
+    if (mode_ == SearchMode::BIDIRECTIONAL) {
+        const std::optional<VertexId> meeting_vertex = RunBidirectionalSearch(from, to);
+        if (!meeting_vertex) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges = UnpackForwardPath(*meeting_vertex);
+        for (std::optional<EdgeId> edge_id = backward_.GetPrevEdge(*meeting_vertex);
+             edge_id;
+             edge_id = backward_.GetPrevEdge(graph_.GetEdge(*edge_id).to))
+        {
+            edges.push_back(*edge_id);
+        }
+        return RouteInfo{forward_.GetWeight(*meeting_vertex) + backward_.GetWeight(*meeting_vertex), std::move(edges)};
+    }
+
+    RunSearch(from, to, [to](VertexId vertex) { return vertex == to; });
+    if (!forward_.IsReached(to)) {
+        return std::nullopt;
+    }
+    return RouteInfo{forward_.GetWeight(to), UnpackForwardPath(to)};
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::ComputeReachableVertices(VertexId from, Weight max_weight) const {
+    if (from >= forward_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+    forward_.Reset();
+    backward_.Reset();
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    RunSearch(from, std::nullopt, [&](VertexId vertex) {
+        const Weight weight = forward_.GetWeight(vertex);
+        if (max_weight < weight) {
+            return true; // vertices are settled by weight, so the rest are even farther
+        }
+        reachable.emplace_back(vertex, weight);
+        return false;
+    });
+    return reachable;
+}
+
+template <typename Weight>
+std::optional<ShortestPathTree<Weight>> DijkstraRouter<Weight>::BuildShortestPathTree(VertexId from) const {
+    const size_t vertex_count = forward_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+    forward_.Reset();
+    backward_.Reset();
+    RunSearch(from, std::nullopt, [](VertexId) { return false; });
+
+    ShortestPathTree<Weight> tree(from, vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (forward_.IsReached(vertex)) {
+            tree.SetRoute(vertex, forward_.GetWeight(vertex), forward_.GetPrevEdge(vertex));
+        }
+    }
+    return tree;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>> DijkstraRouter<Weight>::ComputeRouteWeights(VertexId from,
+                                                                               const std::vector<VertexId>& to) const {
+    const auto is_out_of_range = [this](VertexId vertex) { return vertex >= forward_.GetVertexCount(); };
+    if (is_out_of_range(from) || std::any_of(to.begin(), to.end(), is_out_of_range)) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+
+    std::vector<VertexId> targets(to);
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+    forward_.Reset();
+    backward_.Reset();
+    size_t unsettled_count = targets.size();
+    if (unsettled_count > 0) {
+        RunSearch(from, std::nullopt, [&](VertexId vertex) {
+            return std::binary_search(targets.begin(), targets.end(), vertex) && --unsettled_count == 0;
+        });
+    }
+
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(to.size());
+    for (const VertexId vertex : to) {
+        weights.push_back(forward_.IsReached(vertex) ? std::optional<Weight>(forward_.GetWeight(vertex)) : std::nullopt);
+    }
+    return weights;
+}
+
+}  // namespace graph
@@ -1,21 +1,32 @@
 // A file for defining database structs used across the app.
 
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "geo.h"
 
+// Dense ids assigned by the catalogue in the order of insertion: 0, 1, 2, ...
+using StopId = uint32_t;
+using BusId = uint32_t;
+
 struct Stop{
     std::string name;
     geo::Coordinates coordinates;
+    StopId id;
 };
 
 struct Bus{
     std::string name;
-    std::vector<Stop*> stops;
+    std::vector<StopId> stops; // as they are on the road, the way back included for non-round routes
     double C_route_length;
     bool round_route;
+    BusId id;
+    // kept up to date by the catalogue, so that bus stat requests take no computation
+    double L_route_length = 0; // by roads
+    double curvature = 0; // the road length relative to the geographical one
+    size_t unique_stops_count = 0;
 };
 
 struct BusResponse{
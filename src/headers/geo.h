@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace geo {
 
+constexpr double EARTH_RADIUS = 6371000; // in meters
+
 struct Coordinates {
     double lat; // latitude
     double lng; // longitude
@@ -23,5 +27,31 @@ struct CoordinatesHasher{
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Trigonometry of a point's coordinates, which distance computations would otherwise repeat for every pair the point is in.
+// The sine and cosine of the longitude replace the cosine of the longitude difference of a pair.
+struct PreparedCoordinates {
+    double sin_lat;
+    double cos_lat;
+    double sin_lng;
+    double cos_lng;
+};
+
+PreparedCoordinates PrepareCoordinates(Coordinates coordinates);
+
+// Same as ComputeDistance, up to rounding: within a few millimeters for points a meter apart, and far less for farther ones.
+double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to);
+
+// Number of pairs ComputePathDistances computes at once, as wide as an AVX register of doubles.
+constexpr size_t DISTANCE_LANES = 4;
+
+/** Computes distances between consecutive points of a path, DISTANCE_LANES pairs at a time: the arithmetic of a block
+ * of pairs runs in parallel lanes the compiler packs into SIMD instructions, leaving only the arc cosine per pair.
+ * @param points Prepared coordinates of all points.
+ * @param path Indices of the path points in `points`.
+ * @param path_size Number of points in the path.
+ * @param distances Set to path_size - 1 distances in meters, the first one from path[0] to path[1].
+*/
+void ComputePathDistances(const PreparedCoordinates* points, const uint32_t* path, size_t path_size, double* distances);
+
 
 }  // namespace geo
\ No newline at end of file
@@ -4,7 +4,9 @@
 
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -20,6 +22,17 @@ struct Edge {
     Weight weight; // Time
 };
 
+// An edge as seen from one of its ends: the opposite end plus the payload, stored inline for sequential scans.
+template <typename Weight>
+struct Arc {
+    VertexId vertex; // The head of an outgoing arc or the tail of an incoming one
+    Weight weight;
+    EdgeId edge_id;
+};
+
+template <typename Weight>
+class CsrGraph;
+
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
@@ -29,29 +42,132 @@ private:
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+    VertexId AddVertex();
+    // Takes the id of a removed edge if there is one, so ids stay as many as the most edges the graph has had at once.
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Removes an edge from the incidence lists. Ids of the other edges are kept, the removed one goes to the next added edge.
+    void RemoveEdge(EdgeId edge_id);
+    // Removes edges at once, going over the incidence list of every tail vertex a single time.
+    void RemoveEdges(const std::vector<EdgeId>& edge_ids);
+    void ReserveEdges(size_t edge_count);
 
     size_t GetVertexCount() const;
+    // Number of edge ids given out, the ids of removed edges not reused yet included.
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    bool IsEdgeRemoved(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Packs the graph into an immutable CSR form for searches. Edge ids are kept.
+    CsrGraph<Weight> Freeze() const;
+
 private:
     std::vector<Edge<Weight>> edges_;
+    std::vector<bool> removed_edges_;
+    std::vector<EdgeId> free_edge_ids_; // ids of removed edges, to be given to added ones
     std::vector<IncidenceList> incidence_lists_;
 };
 
+// An immutable graph in compressed sparse row form: arcs of every vertex lie contiguously, in incidence order,
+// so searches scan memory sequentially. Removed edges keep their ids, but have no arcs. Accessors are unchecked.
+template <typename Weight>
+class CsrGraph {
+private:
+    using Arcs = std::vector<Arc<Weight>>;
+    using ArcsRange = ranges::Range<typename Arcs::const_iterator>;
+
+public:
+    CsrGraph() = default;
+    explicit CsrGraph(const DirectedWeightedGraph<Weight>& graph);
+
+    size_t GetVertexCount() const {
+        return outgoing_offsets_.empty() ? 0 : outgoing_offsets_.size() - 1;
+    }
+    size_t GetEdgeCount() const {
+        return edges_.size();
+    }
+    const Edge<Weight>& GetEdge(EdgeId edge_id) const {
+        return edges_[edge_id];
+    }
+    bool IsEdgeRemoved(EdgeId edge_id) const {
+        return removed_edges_[edge_id];
+    }
+    ArcsRange GetOutgoingArcs(VertexId vertex) const {
+        return {outgoing_arcs_.begin() + outgoing_offsets_[vertex], outgoing_arcs_.begin() + outgoing_offsets_[vertex + 1]};
+    }
+    ArcsRange GetIncomingArcs(VertexId vertex) const {
+        return {incoming_arcs_.begin() + incoming_offsets_[vertex], incoming_arcs_.begin() + incoming_offsets_[vertex + 1]};
+    }
+
+private:
+    std::vector<Edge<Weight>> edges_;
+    std::vector<bool> removed_edges_;
+    std::vector<size_t> outgoing_offsets_;
+    Arcs outgoing_arcs_;
+    std::vector<size_t> incoming_offsets_;
+    Arcs incoming_arcs_;
+};
+
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    IncidenceList& incidence_list = incidence_lists_.at(edge.from);
+    if (!free_edge_ids_.empty()) {
+        const EdgeId edge_id = free_edge_ids_.back();
+        free_edge_ids_.pop_back();
+        incidence_list.push_back(edge_id);
+        edges_[edge_id] = edge;
+        removed_edges_[edge_id] = false;
+        return edge_id;
+    }
+    incidence_list.push_back(edges_.size());
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    removed_edges_.push_back(false);
+    return edges_.size() - 1;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    RemoveEdges({edge_id});
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdges(const std::vector<EdgeId>& edge_ids) {
+    std::vector<VertexId> tails;
+    tails.reserve(edge_ids.size());
+    for (const EdgeId edge_id : edge_ids) {
+        if (IsEdgeRemoved(edge_id)) {
+            throw std::logic_error("The edge has already been removed");
+        }
+        removed_edges_[edge_id] = true;
+        tails.push_back(edges_[edge_id].from);
+    }
+    std::sort(tails.begin(), tails.end());
+    tails.erase(std::unique(tails.begin(), tails.end()), tails.end());
+    for (const VertexId tail : tails) {
+        IncidenceList& incidence_list = incidence_lists_[tail];
+        incidence_list.erase(std::remove_if(incidence_list.begin(), incidence_list.end(), [this](EdgeId edge_id) {
+            return removed_edges_[edge_id];
+        }), incidence_list.end());
+    }
+    // the last removed id is given out first, so a removed bus's ids go to the next one in about the same order
+    free_edge_ids_.insert(free_edge_ids_.end(), edge_ids.rbegin(), edge_ids.rend());
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::ReserveEdges(size_t edge_count) {
+    edges_.reserve(edge_count);
+    removed_edges_.reserve(edge_count);
 }
 
 template <typename Weight>
@@ -69,9 +185,58 @@ const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
     return edges_.at(edge_id);
 }
 
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsEdgeRemoved(EdgeId edge_id) const {
+    return removed_edges_.at(edge_id);
+}
+
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+CsrGraph<Weight> DirectedWeightedGraph<Weight>::Freeze() const {
+    return CsrGraph<Weight>(*this);
+}
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(const DirectedWeightedGraph<Weight>& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t edge_count = graph.GetEdgeCount();
+
+    edges_.reserve(edge_count);
+    removed_edges_.reserve(edge_count);
+    outgoing_offsets_.reserve(vertex_count + 1);
+    outgoing_offsets_.push_back(0);
+    outgoing_arcs_.reserve(edge_count);
+    incoming_offsets_.assign(vertex_count + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        edges_.push_back(graph.GetEdge(edge_id));
+        removed_edges_.push_back(graph.IsEdgeRemoved(edge_id));
+        if (!removed_edges_.back()) {
+            ++incoming_offsets_[edges_.back().to + 1];
+        }
+    }
+
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const Edge<Weight>& edge = edges_[edge_id];
+            outgoing_arcs_.push_back({edge.to, edge.weight, edge_id});
+        }
+        outgoing_offsets_.push_back(outgoing_arcs_.size());
+        incoming_offsets_[vertex + 1] += incoming_offsets_[vertex];
+    }
+
+    // Incoming arcs are placed in edge id order, as incidence lists are
+    incoming_arcs_.resize(incoming_offsets_.back());
+    std::vector<size_t> fill_positions(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        const Edge<Weight>& edge = edges_[edge_id];
+        if (!removed_edges_[edge_id]) {
+            incoming_arcs_[fill_positions[edge.to]++] = {edge.from, edge.weight, edge_id};
+        }
+    }
+}
 }  // namespace graph
\ No newline at end of file
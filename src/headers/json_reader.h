@@ -1,36 +1,51 @@
 #pragma once
 
 #include "transport_catalogue.h"
+#include "catalogue_versions.h"
 #include "map_renderer.h"
 #include "json_builder.h" 
 #include "transport_router.h"
+#include "serialization.h"
 
 #include <memory>
 
 // A class for handling `base` and `stat` requests to the DB.
 class TC_QueryHandler{
 public:
-    TC_QueryHandler() = default;
-    TC_QueryHandler(Transportation::TransportCatalogue& transp_catalogue);
+    TC_QueryHandler();
 
 public: // --------- BASE REQUESTS HANDLING --------- 
     void AddStop(const json::Dict& stop);
     void AddBus(const json::Dict& bus);
 
-    // Builds transport database from the base requests.
-    void ProcessBaseRequests();
+    // Builds transport database from the base requests into `transp_catalogue`.
+    void ProcessBaseRequests(Transportation::TransportCatalogue& transp_catalogue);
 
 public: // --------- STAT REQUESTS HANDLING --------- 
+    // Sets the published version of the database the stat requests are answered from.
+    void SetCatalogue(Transportation::CatalogueSnapshot catalogue);
+
     void AddStatStopRequest(const json::Dict& stop_req);
     void AddStatBusRequest(const json::Dict& bus_req);
     void AddStatRouteRequest(const json::Dict& route_req, const std::unique_ptr<Transportation::Router>& router);
+    void AddStatMatrixRequest(const json::Dict& matrix_req, const std::unique_ptr<Transportation::Router>& router);
+    void AddStatIsochroneRequest(const json::Dict& isochrone_req, const std::unique_ptr<Transportation::Router>& router);
+    void AddStatNearestStopsRequest(const json::Dict& nearest_req);
+    void AddStatStopsInRadiusRequest(const json::Dict& radius_req);
     void AddStatMapRequest(const int request_id, const std::string& rendered_map);
 
     // Outputs processed stat requests to `out` stream.
     void ProcessStatRequests(std::ostream& out);
-    
+
+private: // --------- HELPER METHODS ---------
+    // Converts items of a built route into JSON.
+    static json::Array BuildRouteItems(const Transportation::RouteResponse& resp);
+
+    // Converts stops found near a point into a response to the request `request_id`.
+    static json::Node BuildNearbyStops(int request_id, const std::vector<Transportation::NearbyStop>& stops);
+
 private: // --------- FIELDS ---------
-    Transportation::TransportCatalogue& db_;
+    Transportation::CatalogueSnapshot db_;
     std::deque<json::Dict> base_stop_reqs, base_bus_reqs;
     json::Array stat_reqs_output_;
 };
@@ -39,12 +54,22 @@ private: // --------- FIELDS ---------
 class JSON_TC_Builder{
 public: // --------- CONSTRUCTORS ---------
     explicit JSON_TC_Builder() = default;
-    explicit JSON_TC_Builder(Transportation::TransportCatalogue& transport_cat);
+    // Base requests, and databases loaded, are published as versions of `catalogue_versions`, and stat requests are
+    // answered from a snapshot of the version published last.
+    explicit JSON_TC_Builder(Transportation::CatalogueVersions& catalogue_versions);
 
 public: // --------- METHODS ---------
     // Builds data, processes stat_requests, and outputs the responses to `out`.
     void BuildData(std::ostream& out);
 
+    // Builds data from base requests and saves it, along with render and routing settings, to the file of `serialization_settings`.
+    // Precomputed routes are saved as well if routing settings ask for a snapshot.
+    void MakeBase();
+
+    // Loads data saved by MakeBase from the file of `serialization_settings`, processes stat_requests, and outputs the
+    // responses to `out`. Routing settings of the input, if any, replace the saved ones.
+    void ProcessRequests(std::ostream& out);
+
     // Reads JSON data from `in` input stream.
     void ReadData(std::istream& in);
 private: // --------- HELPER METHODS ---------
@@ -54,11 +79,21 @@ private: // --------- HELPER METHODS ---------
     void BuildBaseRequests(const json::Array& base_requests);
     void BuildStatRequests(const json::Array& stat_requests, std::ostream& out);
 
+    // Takes a snapshot of the current version of the database for the map, the router and the stat requests.
+    void AcquireCatalogue();
+
+    // The database file of `serialization_settings`.
+    const std::string& GetBaseFile() const;
+
     // Parses color from a node, if `value` is either an Array or a String.
     static svg::Color ParseColor(const json::Node::Value& value);
 
+    // Parses a `router_backend` routing setting.
+    static Transportation::RouterBackend ParseRouterBackend(const std::string& name);
+
 private: // --------- FIELDS ---------
-    Transportation::TransportCatalogue& transp_ct_;
+    Transportation::CatalogueVersions& catalogue_versions_;
+    Transportation::CatalogueSnapshot transp_ct_; // the map and the router refer to it, so it outlives them
     TC_QueryHandler query_handler_;
     std::unique_ptr<map_renderer::MapRenderer> p_map_rendered_;
     std::unique_ptr<json::Dict> p_read_json_data_;
@@ -7,12 +7,17 @@
 // A class for reading and processing user input.
 class RequestHandler{
 public:
-    RequestHandler(Transportation::TransportCatalogue& db);
+    RequestHandler(Transportation::CatalogueVersions& db);
 
 public: // --------- METHODS ---------
     void ReadInput(std::istream& in);
     void ProcessInput(std::ostream& out);
 
+    // Saves the database built from the read input to a file, for ProcessRequests calls to load it instead of building.
+    void MakeBase();
+    // Answers stat requests of the read input over the database saved by MakeBase.
+    void ProcessRequests(std::ostream& out);
+
 private:
     JSON_TC_Builder data_builder_;
 };
\ No newline at end of file
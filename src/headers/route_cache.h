@@ -0,0 +1,112 @@
+// This file contains a memory-bounded LRU cache of shortest path trees
+
+#pragma once
+
+#include "router.h"
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace graph {
+
+struct RouteCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t tree_count = 0;
+    size_t memory_usage = 0; // bytes taken by the cached trees
+};
+
+// Keeps the shortest path trees of the most recently queried sources, within a memory budget.
+// Routes from a cached source are built by walking its tree, without searching.
+template <typename Weight>
+class RouteCache {
+public:
+    using Tree = ShortestPathTree<Weight>;
+
+    // @param memory_budget Bytes the cached trees may take at most.
+    explicit RouteCache(size_t memory_budget)
+        : memory_budget_(memory_budget) {
+    }
+
+    // Returns the tree of `source` and marks it as the most recently used one, or nullptr if it is not cached.
+    const Tree* Find(VertexId source) {
+        const auto it = source_to_tree_.find(source);
+        if (it == source_to_tree_.end()) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        ++stats_.hits;
+        trees_.splice(trees_.begin(), trees_, it->second);
+        return &*it->second;
+    }
+
+    // Caches a tree, evicting the least recently used ones to fit it in the budget.
+    // Returns the cached tree, or nullptr if the tree alone exceeds the budget.
+    const Tree* Insert(Tree tree) {
+        const size_t tree_memory = tree.GetMemoryUsage();
+        if (tree_memory > memory_budget_) {
+            return nullptr;
+        }
+        if (const auto it = source_to_tree_.find(tree.GetSource()); it != source_to_tree_.end()) {
+            Erase(it->second);
+        }
+        while (stats_.memory_usage + tree_memory > memory_budget_) {
+            Erase(std::prev(trees_.end()));
+            ++stats_.evictions;
+        }
+
+        trees_.push_front(std::move(tree));
+        source_to_tree_[trees_.front().GetSource()] = trees_.begin();
+        stats_.memory_usage += tree_memory;
+        ++stats_.tree_count;
+        return &trees_.front();
+    }
+
+    // Drops all trees, e.g. when the graph they were built on changes. Counters are kept.
+    void Clear() {
+        trees_.clear();
+        source_to_tree_.clear();
+        stats_.tree_count = 0;
+        stats_.memory_usage = 0;
+    }
+
+    // Drops the trees `is_stale` holds for, e.g. ones a graph change has made wrong. Returns the number of dropped trees.
+    template <typename Predicate>
+    size_t EraseIf(Predicate is_stale) {
+        size_t erased_count = 0;
+        for (auto it = trees_.begin(); it != trees_.end();) {
+            const auto next = std::next(it);
+            if (is_stale(*it)) {
+                Erase(it);
+                ++erased_count;
+            }
+            it = next;
+        }
+        return erased_count;
+    }
+
+    const RouteCacheStats& GetStats() const {
+        return stats_;
+    }
+
+private:
+    using TreeList = std::list<Tree>;
+
+    void Erase(typename TreeList::iterator it) {
+        stats_.memory_usage -= it->GetMemoryUsage();
+        --stats_.tree_count;
+        source_to_tree_.erase(it->GetSource());
+        trees_.erase(it);
+    }
+
+    const size_t memory_budget_;
+    TreeList trees_; // the most recently used first
+    std::unordered_map<VertexId, typename TreeList::iterator> source_to_tree_;
+    RouteCacheStats stats_;
+};
+
+}  // namespace graph
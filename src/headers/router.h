@@ -1,11 +1,14 @@
 #pragma once
 
 #include "graph.h"
+#include "search_space.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -16,105 +19,546 @@
 
 namespace graph {
 
-// Main Transport Router class.
 template <typename Weight>
-class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
-
-public: // --------- MAIN PUBLIC API ---------
-    explicit Router(const Graph& graph);
+class ShortestPathTree;
 
+// Common interface of the graph routing backends.
+template <typename Weight>
+class RouterBase {
+public:
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    virtual ~RouterBase() = default;
 
-private: // --------- HELPER METHODS ---------
-    struct RouteInternalData {
+    // Builds the lightest route from `from` to `to`, or std::nullopt if `to` is unreachable.
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Number of vertices of the graph the routes are built on.
+    virtual size_t GetVertexCount() const = 0;
+
+    // Computes weights of the lightest routes from `from` to every vertex of `to` (std::nullopt for unreachable ones).
+    virtual std::vector<std::optional<Weight>> ComputeRouteWeights(VertexId from, const std::vector<VertexId>& to) const {
+        std::vector<std::optional<Weight>> weights;
+        weights.reserve(to.size());
+        for (const VertexId vertex : to) {
+            const std::optional<RouteInfo> route = BuildRoute(from, vertex);
+            weights.push_back(route ? std::optional<Weight>(route->weight) : std::nullopt);
+        }
+        return weights;
+    }
+
+    // Computes weights of the lightest routes from every vertex of `from` to every vertex of `to`, a row per `from` vertex.
+    virtual std::vector<std::vector<std::optional<Weight>>> ComputeRouteWeightMatrix(const std::vector<VertexId>& from,
+                                                                                     const std::vector<VertexId>& to) const {
+        std::vector<std::vector<std::optional<Weight>>> matrix;
+        matrix.reserve(from.size());
+        for (const VertexId vertex : from) {
+            matrix.push_back(ComputeRouteWeights(vertex, to));
+        }
+        return matrix;
+    }
+
+    // Collects vertices reachable from `from` by routes weighing at most `max_weight`, along with the route weights.
+    virtual std::vector<std::pair<VertexId, Weight>> ComputeReachableVertices(VertexId from, Weight max_weight) const {
+        std::vector<VertexId> vertices(GetVertexCount());
+        for (VertexId vertex = 0; vertex < vertices.size(); ++vertex) {
+            vertices[vertex] = vertex;
+        }
+        const std::vector<std::optional<Weight>> weights = ComputeRouteWeights(from, vertices);
+
+        std::vector<std::pair<VertexId, Weight>> reachable;
+        for (VertexId vertex = 0; vertex < vertices.size(); ++vertex) {
+            if (weights[vertex] && !(max_weight < *weights[vertex])) {
+                reachable.emplace_back(vertex, *weights[vertex]);
+            }
+        }
+        return reachable;
+    }
+
+    // Builds the lightest routes from `from` to all vertices, or std::nullopt if the router does not search at query time.
+    virtual std::optional<ShortestPathTree<Weight>> BuildShortestPathTree(VertexId /*from*/) const {
+        return std::nullopt;
+    }
+
+    // Number of vertices settled by the last BuildRoute call (0 for routers that do not search at query time).
+    virtual size_t GetSettledCount() const {
+        return 0;
+    }
+
+    // Brings the router in line with its graph after vertices and edges have been added to it or edges removed from it
+    // (the graph object staying the same). Returns false if the router cannot be updated in place and must be rebuilt.
+    virtual bool UpdateEdges(const std::vector<EdgeId>& /*added_edges*/, const std::vector<EdgeId>& /*removed_edges*/) {
+        return false;
+    }
+};
+
+// The lightest routes from one vertex to all others, kept as the last edge of every route.
+template <typename Weight>
+class ShortestPathTree {
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    ShortestPathTree(VertexId source, size_t vertex_count)
+        : source_(source)
+        , weights_(vertex_count)
+        , prev_edges_(vertex_count, NO_EDGE) {
+    }
+
+    VertexId GetSource() const {
+        return source_;
+    }
+
+    void SetRoute(VertexId to, Weight weight, std::optional<EdgeId> prev_edge) {
+        weights_[to] = weight;
+        prev_edges_[to] = prev_edge ? *prev_edge : NO_EDGE;
+    }
+
+    bool HasRoute(VertexId to) const {
+        return to == source_ || prev_edges_[to] != NO_EDGE;
+    }
+    Weight GetWeight(VertexId to) const {
+        return weights_[to];
+    }
+    std::optional<EdgeId> GetPrevEdge(VertexId to) const {
+        return prev_edges_[to] == NO_EDGE ? std::nullopt : std::optional<EdgeId>(prev_edges_[to]);
+    }
+    size_t GetVertexCount() const {
+        return weights_.size();
+    }
+
+    // Builds the route to `to` by walking the tree up, or std::nullopt if `to` is unreachable.
+    std::optional<RouteInfo> BuildRoute(VertexId to, const CsrGraph<Weight>& graph) const {
+        if (to >= prev_edges_.size()) {
+            throw std::out_of_range("Vertex id is out of the graph's range");
+        }
+        if (!HasRoute(to)) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = to; vertex != source_; vertex = graph.GetEdge(prev_edges_[vertex]).from) {
+            edges.push_back(prev_edges_[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+        return RouteInfo{weights_[to], std::move(edges)};
+    }
+
+    // Approximate heap memory taken by the tree, in bytes.
+    size_t GetMemoryUsage() const {
+        return GetMemoryUsage(weights_.size());
+    }
+    static size_t GetMemoryUsage(size_t vertex_count) {
+        return vertex_count * (sizeof(Weight) + sizeof(EdgeId));
+    }
+
+private:
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    VertexId source_;
+    std::vector<Weight> weights_;
+    std::vector<EdgeId> prev_edges_;
+};
+
+// Route table layouts for Router. A table keeps the weight of the lightest route and its last edge
+// for every pair of vertices; cells are addressed by `from * vertex_count + to`.
+
+// Exact layout: the route weight and edge id as they are (32 bytes per cell).
+template <typename Weight>
+class ExactRouteTable {
+public:
+    static constexpr bool HAS_EXACT_WEIGHTS = true;
+    static constexpr size_t MAX_EDGE_COUNT = std::numeric_limits<EdgeId>::max();
+
+    explicit ExactRouteTable(size_t cell_count, size_t /*edge_count*/)
+        : cells_(cell_count) {
+    }
+
+    bool HasRoute(size_t cell) const {
+        return cells_[cell].has_value();
+    }
+    Weight GetWeight(size_t cell) const {
+        return cells_[cell]->weight;
+    }
+    std::optional<EdgeId> GetPrevEdge(size_t cell) const {
+        return cells_[cell]->prev_edge;
+    }
+    void SetRoute(size_t cell, Weight weight, std::optional<EdgeId> prev_edge) {
+        cells_[cell] = Cell{weight, prev_edge};
+    }
+    void ClearRoute(size_t cell) {
+        cells_[cell].reset();
+    }
+
+    // Relaxes `count` cells starting at `relaxing_cell` with routes made of the route (`from_weight`, `from_prev_edge`)
+    // followed by the routes of the corresponding cells starting at `through_cell`.
+    void RelaxRange(size_t relaxing_cell, size_t through_cell, size_t count, Weight from_weight,
+                    std::optional<EdgeId> from_prev_edge) {
+        for (size_t i = 0; i < count; ++i) {
+            const std::optional<Cell>& route_to = cells_[through_cell + i];
+            if (!route_to) {
+                continue;
+            }
+            std::optional<Cell>& route_relaxing = cells_[relaxing_cell + i];
+            const Weight candidate_weight = from_weight + route_to->weight;
+            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+                route_relaxing = Cell{candidate_weight, route_to->prev_edge ? route_to->prev_edge : from_prev_edge};
+            }
+        }
+    }
+
+private:
+    struct Cell {
         Weight weight;
         std::optional<EdgeId> prev_edge;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    std::vector<std::optional<Cell>> cells_;
+};
+
+// Compact layout (8 bytes per cell): `float` weights and 32-bit edge ids in two separate arrays, with sentinels
+// instead of optionals. Weights are only used to compare routes, while the weight of a built route is summed
+// up from its edges, so rounding can only affect the choice between routes of almost equal weight.
+template <typename Weight>
+class CompactRouteTable {
+public:
+    static constexpr bool HAS_EXACT_WEIGHTS = false;
+    static constexpr size_t MAX_EDGE_COUNT = std::numeric_limits<uint32_t>::max(); // the largest id is the sentinel
+    static constexpr float NO_ROUTE = std::numeric_limits<float>::infinity();
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    explicit CompactRouteTable(size_t cell_count, size_t edge_count)
+        : weights_(cell_count, NO_ROUTE)
+        , prev_edges_(cell_count, NO_EDGE)
+    {
+        if (edge_count > MAX_EDGE_COUNT) {
+            throw std::length_error("Too many edges for a compact route table");
+        }
+    }
+
+    bool HasRoute(size_t cell) const {
+        return weights_[cell] != NO_ROUTE;
+    }
+    Weight GetWeight(size_t cell) const {
+        return static_cast<Weight>(weights_[cell]);
+    }
+    std::optional<EdgeId> GetPrevEdge(size_t cell) const {
+        return prev_edges_[cell] == NO_EDGE ? std::nullopt : std::optional<EdgeId>(prev_edges_[cell]);
+    }
+    void SetRoute(size_t cell, Weight weight, std::optional<EdgeId> prev_edge) {
+        weights_[cell] = static_cast<float>(weight);
+        prev_edges_[cell] = prev_edge ? static_cast<uint32_t>(*prev_edge) : NO_EDGE;
+    }
+    void ClearRoute(size_t cell) {
+        weights_[cell] = NO_ROUTE;
+        prev_edges_[cell] = NO_EDGE;
+    }
+
+    // Raw cell arrays, with NO_ROUTE and NO_EDGE for missing routes, e.g. to write the table out.
+    const std::vector<float>& GetWeights() const {
+        return weights_;
+    }
+    const std::vector<uint32_t>& GetPrevEdges() const {
+        return prev_edges_;
+    }
+
+    // Same as ExactRouteTable::RelaxRange. Missing routes weigh infinity, so the loop needs no branches and vectorizes.
+    void RelaxRange(size_t relaxing_cell, size_t through_cell, size_t count, Weight from_weight,
+                    std::optional<EdgeId> from_prev_edge) {
+        const float from_cell_weight = static_cast<float>(from_weight);
+        const uint32_t from_cell_prev_edge = from_prev_edge ? static_cast<uint32_t>(*from_prev_edge) : NO_EDGE;
+        float* relaxing_weights = weights_.data() + relaxing_cell;
+        uint32_t* relaxing_prev_edges = prev_edges_.data() + relaxing_cell;
+        const float* through_weights = weights_.data() + through_cell;
+        const uint32_t* through_prev_edges = prev_edges_.data() + through_cell;
+
+        for (size_t i = 0; i < count; ++i) {
+            const float candidate_weight = from_cell_weight + through_weights[i];
+            const bool is_lighter = candidate_weight < relaxing_weights[i];
+            const uint32_t candidate_prev_edge = through_prev_edges[i] != NO_EDGE ? through_prev_edges[i] : from_cell_prev_edge;
+            relaxing_weights[i] = is_lighter ? candidate_weight : relaxing_weights[i];
+            relaxing_prev_edges[i] = is_lighter ? candidate_prev_edge : relaxing_prev_edges[i];
+        }
+    }
+
+private:
+    std::vector<float> weights_;
+    std::vector<uint32_t> prev_edges_;
+};
+
+// Main Transport Router class. Precomputes routes between all pairs of vertices (Floyd-Warshall).
+// The route table is a single row-major matrix, relaxed block by block, so that every step works on
+// cache-sized tiles and independent tiles of a step are processed in parallel.
+// Graph changes are applied to the table in place: rows using removed edges are searched anew and added
+// edges are relaxed through, which takes O(V^2) per changed vertex instead of O(V^3).
+template <typename Weight, typename RouteTable = ExactRouteTable<Weight>>
+class Router : public RouterBase<Weight> {
+private:
+    using Graph = CsrGraph<Weight>;
+
+public: // --------- MAIN PUBLIC API ---------
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    /**
+     * @param graph A graph to precompute routes on.
+     * @param thread_count Number of threads used for the precomputation.
+    */
+    explicit Router(const Graph& graph, size_t thread_count = threading::ThreadPool::GetDefaultThreadCount());
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    size_t GetVertexCount() const override {
+        return vertex_count_;
+    }
+
+    // Reads weights right from the table if it keeps them exactly, otherwise sums them up by routes.
+    std::vector<std::optional<Weight>> ComputeRouteWeights(VertexId from, const std::vector<VertexId>& to) const override {
+        if constexpr (!RouteTable::HAS_EXACT_WEIGHTS) {
+            return RouterBase<Weight>::ComputeRouteWeights(from, to);
+        }
+        std::vector<std::optional<Weight>> weights;
+        weights.reserve(to.size());
+        for (const VertexId vertex : to) {
+            if (from >= vertex_count_ || vertex >= vertex_count_) {
+                throw std::out_of_range("Vertex id is out of the graph's range");
+            }
+            const size_t cell = GetCell(from, vertex);
+            weights.push_back(routes_internal_data_.HasRoute(cell) ? std::optional<Weight>(routes_internal_data_.GetWeight(cell)) : std::nullopt);
+        }
+        return weights;
+    }
+
+    bool UpdateEdges(const std::vector<EdgeId>& added_edges, const std::vector<EdgeId>& removed_edges) override;
+
+    // The precomputed routes, cells addressed by `from * vertex_count + to`.
+    const RouteTable& GetRouteTable() const {
+        return routes_internal_data_;
+    }
+
+private: // --------- HELPER METHODS ---------
+    // Side of the square tiles the route table is processed by.
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    size_t GetCell(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            routes_internal_data_.SetRoute(GetCell(vertex, vertex), ZERO_WEIGHT, std::nullopt);
+            for (const Arc<Weight>& arc : graph.GetOutgoingArcs(vertex)) {
+                if (arc.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t cell = GetCell(vertex, arc.vertex);
+                if (!routes_internal_data_.HasRoute(cell) || routes_internal_data_.GetWeight(cell) > arc.weight) {
+                    routes_internal_data_.SetRoute(cell, arc.weight, arc.edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // Relaxes routes from the vertices of `from_block` to the vertices of `to_block` through the vertices of `through_block`.
+    void RelaxBlockThroughBlock(size_t from_block, size_t to_block, size_t through_block) {
+        const VertexId from_end = std::min(vertex_count_, (from_block + 1) * BLOCK_SIZE);
+        const VertexId to_end = std::min(vertex_count_, (to_block + 1) * BLOCK_SIZE);
+        const VertexId through_end = std::min(vertex_count_, (through_block + 1) * BLOCK_SIZE);
+
+        for (VertexId vertex_through = through_block * BLOCK_SIZE; vertex_through < through_end; ++vertex_through) {
+            for (VertexId vertex_from = from_block * BLOCK_SIZE; vertex_from < from_end; ++vertex_from) {
+                const size_t route_from = GetCell(vertex_from, vertex_through);
+                if (!routes_internal_data_.HasRoute(route_from)) {
+                    continue;
+                }
+                const VertexId to_begin = to_block * BLOCK_SIZE;
+                routes_internal_data_.RelaxRange(GetCell(vertex_from, to_begin), GetCell(vertex_through, to_begin), to_end - to_begin,
+                                                 routes_internal_data_.GetWeight(route_from), routes_internal_data_.GetPrevEdge(route_from));
+            }
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    // Blocked Floyd-Warshall. For each diagonal block: relaxes the block itself, then its block row and column
+    // (all independent of each other), then all the remaining blocks (independent as well).
+    void ComputeRoutesInternalData(size_t thread_count) {
+        threading::ThreadPool thread_pool(thread_count);
+        const size_t block_count = (vertex_count_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        for (size_t through_block = 0; through_block < block_count; ++through_block) {
+            RelaxBlockThroughBlock(through_block, through_block, through_block);
+
+            thread_pool.ParallelFor(2 * block_count, [&](size_t task) {
+                const size_t block = task / 2;
+                if (block == through_block) {
+                    return;
+                }
+                if (task % 2 == 0) {
+                    RelaxBlockThroughBlock(through_block, block, through_block);
                 }
+                else {
+                    RelaxBlockThroughBlock(block, through_block, through_block);
+                }
+            });
+
+            thread_pool.ParallelFor(block_count * block_count, [&](size_t task) {
+                const size_t from_block = task / block_count;
+                const size_t to_block = task % block_count;
+                if (from_block != through_block && to_block != through_block) {
+                    RelaxBlockThroughBlock(from_block, to_block, through_block);
+                }
+            });
+        }
+    }
+
+    // Copies the table into a larger one after vertices have been added to the graph. New vertices get no routes but to themselves.
+    void GrowRoutesInternalData() {
+        const size_t old_vertex_count = vertex_count_;
+        vertex_count_ = graph_.GetVertexCount();
+        RouteTable routes(vertex_count_ * vertex_count_, graph_.GetEdgeCount());
+        for (VertexId from = 0; from < old_vertex_count; ++from) {
+            for (VertexId to = 0; to < old_vertex_count; ++to) {
+                const size_t old_cell = from * old_vertex_count + to;
+                if (routes_internal_data_.HasRoute(old_cell)) {
+                    routes.SetRoute(GetCell(from, to), routes_internal_data_.GetWeight(old_cell), routes_internal_data_.GetPrevEdge(old_cell));
+                }
+            }
+        }
+        for (VertexId vertex = old_vertex_count; vertex < vertex_count_; ++vertex) {
+            routes.SetRoute(GetCell(vertex, vertex), ZERO_WEIGHT, std::nullopt);
+        }
+        routes_internal_data_ = std::move(routes);
+    }
+
+    // Replaces the routes from `from` with the ones found by a Dijkstra search over the graph.
+    void RecomputeRow(VertexId from, SearchSpace<Weight>& space) {
+        for (VertexId to = 0; to < vertex_count_; ++to) {
+            routes_internal_data_.ClearRoute(GetCell(from, to));
+        }
+        space.Reset();
+        space.Reach(from, ZERO_WEIGHT, ZERO_WEIGHT, std::nullopt);
+        while (space.HasNext()) {
+            const VertexId vertex = space.SettleNext();
+            const Weight vertex_weight = space.GetWeight(vertex);
+            routes_internal_data_.SetRoute(GetCell(from, vertex), vertex_weight, space.GetPrevEdge(vertex));
+            for (const Arc<Weight>& arc : graph_.GetOutgoingArcs(vertex)) {
+                space.Relax(arc.vertex, vertex_weight + arc.weight, ZERO_WEIGHT, arc.edge_id);
             }
         }
     }
+
+    // Relaxes routes between all pairs of vertices through `vertex_through`: a single Floyd-Warshall step.
+    void RelaxThroughVertex(VertexId vertex_through, threading::ThreadPool& thread_pool) {
+        const size_t block_count = (vertex_count_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        thread_pool.ParallelFor(block_count, [&](size_t from_block) {
+            const VertexId from_end = std::min(vertex_count_, (from_block + 1) * BLOCK_SIZE);
+            for (VertexId vertex_from = from_block * BLOCK_SIZE; vertex_from < from_end; ++vertex_from) {
+                const size_t route_from = GetCell(vertex_from, vertex_through);
+                if (vertex_from == vertex_through || !routes_internal_data_.HasRoute(route_from)) {
+                    continue;
+                }
+                routes_internal_data_.RelaxRange(GetCell(vertex_from, 0), GetCell(vertex_through, 0), vertex_count_,
+                                                 routes_internal_data_.GetWeight(route_from), routes_internal_data_.GetPrevEdge(route_from));
+            }
+        });
+    }
+
 private: // --------- FIELDS ---------
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    const size_t thread_count_;
+    size_t vertex_count_;
+    RouteTable routes_internal_data_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename RouteTable>
+Router<Weight, RouteTable>::Router(const Graph& graph, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , thread_count_(thread_count)
+    , vertex_count_(graph.GetVertexCount())
+    , routes_internal_data_(vertex_count_ * vertex_count_, graph.GetEdgeCount())
 {
     InitializeRoutesInternalData(graph);
-
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
-    }
+    ComputeRoutesInternalData(thread_count);
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+template <typename Weight, typename RouteTable>
+std::optional<typename Router<Weight, RouteTable>::RouteInfo> Router<Weight, RouteTable>::BuildRoute(VertexId from,
+                                                                                                     VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of the graph's range");
+    }
+    const size_t route_cell = GetCell(from, to);
+    if (!routes_internal_data_.HasRoute(route_cell)) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    Weight weight = RouteTable::HAS_EXACT_WEIGHTS ? routes_internal_data_.GetWeight(route_cell) : ZERO_WEIGHT;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
+    for (std::optional<EdgeId> edge_id = routes_internal_data_.GetPrevEdge(route_cell);
          edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+         edge_id = routes_internal_data_.GetPrevEdge(GetCell(from, graph_.GetEdge(*edge_id).from)))
     {
         edges.push_back(*edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
+    if constexpr (!RouteTable::HAS_EXACT_WEIGHTS) {
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+    }
     return RouteInfo{weight, std::move(edges)};
 }
 
-}  // namespace graph
\ No newline at end of file
+template <typename Weight, typename RouteTable>
+bool Router<Weight, RouteTable>::UpdateEdges(const std::vector<EdgeId>& added_edges, const std::vector<EdgeId>& removed_edges) {
+    if (graph_.GetEdgeCount() > RouteTable::MAX_EDGE_COUNT) {
+        throw std::length_error("Too many edges for the route table");
+    }
+    for (const EdgeId edge_id : added_edges) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    if (graph_.GetVertexCount() != vertex_count_) {
+        GrowRoutesInternalData();
+    }
+    threading::ThreadPool thread_pool(thread_count_);
+
+    // Removing an edge can only make routes heavier, and only routes through it: these are the rows where the edge
+    // is the last one of the route to its head. Such rows are searched anew on the updated graph.
+    std::vector<VertexId> stale_rows;
+    for (VertexId from = 0; from < vertex_count_; ++from) {
+        const bool is_stale = std::any_of(removed_edges.begin(), removed_edges.end(), [&](EdgeId edge_id) {
+            return routes_internal_data_.GetPrevEdge(GetCell(from, graph_.GetEdge(edge_id).to)) == edge_id;
+        });
+        if (is_stale) {
+            stale_rows.push_back(from);
+        }
+    }
+    thread_pool.ParallelFor(std::min(stale_rows.size(), thread_count_), [&](size_t task) {
+        SearchSpace<Weight> space(vertex_count_);
+        for (size_t i = task; i < stale_rows.size(); i += thread_count_) {
+            RecomputeRow(stale_rows[i], space);
+        }
+    });
+
+    // Added edges are put in the table as routes of their own, then routes are relaxed through their ends: any new
+    // lighter route is a chain of old routes and added edges joined at these ends.
+    std::vector<VertexId> changed_vertices;
+    for (const EdgeId edge_id : added_edges) {
+        const Edge<Weight>& edge = graph_.GetEdge(edge_id);
+        const size_t cell = GetCell(edge.from, edge.to);
+        if (!routes_internal_data_.HasRoute(cell) || edge.weight < routes_internal_data_.GetWeight(cell)) {
+            routes_internal_data_.SetRoute(cell, edge.weight, edge_id);
+        }
+        changed_vertices.push_back(edge.from);
+        changed_vertices.push_back(edge.to);
+    }
+    std::sort(changed_vertices.begin(), changed_vertices.end());
+    changed_vertices.erase(std::unique(changed_vertices.begin(), changed_vertices.end()), changed_vertices.end());
+    for (const VertexId vertex : changed_vertices) {
+        RelaxThroughVertex(vertex, thread_pool);
+    }
+    return true;
+}
+
+}  // namespace graph
@@ -0,0 +1,138 @@
+// This file contains reusable buffers of label-setting (Dijkstra-like) graph searches
+
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace graph {
+
+// Search state of every vertex plus the priority queue of one search direction.
+// States are valid only for the current search, so a new search starts in O(1) instead of O(V).
+template <typename Weight>
+class SearchSpace {
+public:
+    SearchSpace() = default;
+    explicit SearchSpace(size_t vertex_count) {
+        Resize(vertex_count);
+    }
+
+    void Resize(size_t vertex_count) {
+        states_.assign(vertex_count, VertexState{});
+        heap_.clear();
+        heap_.reserve(vertex_count);
+        current_stamp_ = 0;
+    }
+
+    size_t GetVertexCount() const {
+        return states_.size();
+    }
+
+    // Starts a new search: invalidates all vertex states and clears the queue.
+    void Reset() {
+        if (++current_stamp_ == 0) { // the stamp counter has wrapped around, reset states for real
+            std::fill(states_.begin(), states_.end(), VertexState{});
+            current_stamp_ = 1;
+        }
+        heap_.clear();
+        settled_count_ = 0;
+    }
+
+    bool IsReached(VertexId vertex) const {
+        return states_[vertex].stamp == current_stamp_;
+    }
+    bool IsSettled(VertexId vertex) const {
+        return IsReached(vertex) && states_[vertex].settled;
+    }
+    Weight GetWeight(VertexId vertex) const {
+        return states_[vertex].weight;
+    }
+    Weight GetPotential(VertexId vertex) const {
+        return states_[vertex].potential;
+    }
+    // An edge the vertex has been reached by (or left by, for backward searches).
+    std::optional<EdgeId> GetPrevEdge(VertexId vertex) const {
+        return states_[vertex].prev_edge;
+    }
+    size_t GetSettledCount() const {
+        return settled_count_;
+    }
+
+    // Labels `vertex` with `weight` and queues it by `weight + potential`.
+    void Reach(VertexId vertex, Weight weight, Weight potential, std::optional<EdgeId> prev_edge) {
+        states_[vertex] = VertexState{weight, potential, prev_edge, current_stamp_, false};
+        heap_.push_back({weight + potential, vertex});
+        std::push_heap(heap_.begin(), heap_.end());
+    }
+
+    // Labels `vertex` if it has not been reached yet or if `weight` improves its unsettled label. Returns true on success.
+    bool Relax(VertexId vertex, Weight weight, Weight potential, std::optional<EdgeId> prev_edge) {
+        if (IsReached(vertex)) {
+            const VertexState& state = states_[vertex];
+            if (state.settled || !(weight < state.weight)) {
+                return false;
+            }
+        }
+        Reach(vertex, weight, potential, prev_edge);
+        return true;
+    }
+
+    // Drops outdated entries from the top of the queue. Returns false if the queue has run out.
+    bool HasNext() {
+        while (!heap_.empty()) {
+            const QueueEntry& top = heap_.front();
+            const VertexState& state = states_[top.vertex];
+            if (!state.settled && !(state.weight + state.potential < top.key)) {
+                return true;
+            }
+            std::pop_heap(heap_.begin(), heap_.end());
+            heap_.pop_back();
+        }
+        return false;
+    }
+
+    // A queue key of the next vertex to settle. HasNext() must be true.
+    Weight PeekKey() const {
+        return heap_.front().key;
+    }
+
+    // Settles the lightest queued vertex and returns it. HasNext() must be true.
+    VertexId SettleNext() {
+        std::pop_heap(heap_.begin(), heap_.end());
+        const VertexId vertex = heap_.back().vertex;
+        heap_.pop_back();
+        states_[vertex].settled = true;
+        ++settled_count_;
+        return vertex;
+    }
+
+private:
+    struct QueueEntry {
+        Weight key;
+        VertexId vertex;
+
+        // Inverted, so that std::push_heap/std::pop_heap keep the lightest entry on top.
+        bool operator<(const QueueEntry& other) const {
+            return other.key < key;
+        }
+    };
+
+    struct VertexState {
+        Weight weight;
+        Weight potential;
+        std::optional<EdgeId> prev_edge;
+        uint32_t stamp = 0;
+        bool settled = false;
+    };
+
+    std::vector<VertexState> states_;
+    std::vector<QueueEntry> heap_;
+    uint32_t current_stamp_ = 0;
+    size_t settled_count_ = 0;
+};
+
+}  // namespace graph
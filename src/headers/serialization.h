@@ -0,0 +1,34 @@
+// This file contains saving and loading of the transport database in a compact binary form
+
+#pragma once
+
+#include "json.h"
+#include "transport_catalogue.h"
+
+#include <string>
+
+namespace serialization {
+
+// Settings saved along with the database, as they have been read from JSON.
+struct BaseSettings {
+    json::Dict render_settings;
+    json::Dict routing_settings;
+};
+
+/** Saves the database and its settings to a file: stops, buses, road distances and the settings.
+ * @param path A file to write.
+ * @param transp_db A transport database to save.
+ * @param settings Settings to save along.
+ * @throws std::runtime_error if the file cannot be written.
+*/
+void SaveBase(const std::string& path, const Transportation::TransportCatalogue& transp_db, const BaseSettings& settings);
+
+/** Loads a database saved by SaveBase.
+ * @param path A file to read.
+ * @param transp_db An empty transport database to fill.
+ * @returns The settings saved along with the database.
+ * @throws std::runtime_error if the file cannot be read or does not contain a database of the current version.
+*/
+BaseSettings LoadBase(const std::string& path, Transportation::TransportCatalogue& transp_db);
+
+}  // namespace serialization
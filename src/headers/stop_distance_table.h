@@ -0,0 +1,124 @@
+// This file contains a flat hash table of road distances between stops
+
+#pragma once
+
+#include "domain.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Transportation{
+
+// Road distances between pairs of stops, in an open-addressing table with linear probing.
+// Both directions of a pair share a slot, so a distance and its fallback to the opposite direction are found in a single probe sequence.
+class StopDistanceTable{
+public:
+    // Sets the distance from `from` to `to`, replacing the one set before.
+    void Set(StopId from, StopId to, int distance){
+        if ((size_ + 1) * 2 > slots_.size()){ // the load factor is kept at most 1/2
+            Rehash(slots_.empty() ? MIN_CAPACITY : slots_.size() * 2);
+        }
+        Slot& slot = slots_[FindSlot(MakeKey(from, to))];
+        if (slot.key == EMPTY_KEY){
+            slot.key = MakeKey(from, to);
+            ++size_;
+        }
+        int& slot_distance = from <= to ? slot.forward : slot.backward;
+        if (slot_distance == NO_DISTANCE){
+            ++distance_count_;
+        }
+        slot_distance = distance;
+    }
+
+    // Returns the distance from `from` to `to`, or the one in the opposite direction if only that one is set, or 0 if neither is.
+    int Get(StopId from, StopId to) const noexcept{
+        if (slots_.empty()){
+            return 0;
+        }
+        const Slot& slot = slots_[FindSlot(MakeKey(from, to))];
+        if (slot.key == EMPTY_KEY){
+            return 0;
+        }
+        const int distance = from <= to ? slot.forward : slot.backward;
+        const int inverse_distance = from <= to ? slot.backward : slot.forward;
+        return distance != NO_DISTANCE ? distance : inverse_distance != NO_DISTANCE ? inverse_distance : 0;
+    }
+
+    // Calls `callback(from, to, distance)` for every distance set, in no particular order.
+    template <typename Callback>
+    void ForEach(Callback callback) const{
+        for (const Slot& slot : slots_){
+            if (slot.key == EMPTY_KEY){
+                continue;
+            }
+            const StopId lower = static_cast<StopId>(slot.key >> 32);
+            const StopId upper = static_cast<StopId>(slot.key);
+            if (slot.forward != NO_DISTANCE){
+                callback(lower, upper, slot.forward);
+            }
+            if (slot.backward != NO_DISTANCE && lower != upper){
+                callback(upper, lower, slot.backward);
+            }
+        }
+    }
+
+    // Number of distances set, either direction of a pair counted separately.
+    size_t GetSize() const noexcept{
+        return distance_count_;
+    }
+
+    size_t GetMemoryUsage() const noexcept{
+        return slots_.capacity() * sizeof(Slot);
+    }
+
+private:
+    static constexpr int NO_DISTANCE = std::numeric_limits<int>::min();
+    static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    struct Slot{
+        uint64_t key = EMPTY_KEY; // the lower stop id in the high half
+        int forward = NO_DISTANCE; // from the lower stop id to the upper one
+        int backward = NO_DISTANCE;
+    };
+
+    static uint64_t MakeKey(StopId from, StopId to) noexcept{
+        return from <= to ? (static_cast<uint64_t>(from) << 32) | to : (static_cast<uint64_t>(to) << 32) | from;
+    }
+
+    // The splitmix64 finalizer: every bit of the key affects the low bits used for the slot index.
+    static uint64_t Mix(uint64_t key) noexcept{
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+        return key ^ (key >> 31);
+    }
+
+    // Index of the slot holding `key`, or of the empty slot ending its probe sequence.
+    size_t FindSlot(uint64_t key) const noexcept{
+        const size_t mask = slots_.size() - 1;
+        for (size_t index = Mix(key) & mask;; index = (index + 1) & mask){
+            if (slots_[index].key == key || slots_[index].key == EMPTY_KEY){
+                return index;
+            }
+        }
+    }
+
+    void Rehash(size_t capacity){
+        std::vector<Slot> slots(capacity);
+        std::swap(slots, slots_);
+        for (const Slot& slot : slots){
+            if (slot.key != EMPTY_KEY){
+                slots_[FindSlot(slot.key)] = slot;
+            }
+        }
+    }
+
+    std::vector<Slot> slots_; // the size is a power of two
+    size_t size_ = 0; // occupied slots
+    size_t distance_count_ = 0;
+};
+
+} // namespace Transportation
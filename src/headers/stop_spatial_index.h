@@ -0,0 +1,84 @@
+// This file contains a spatial index over the coordinates of stops
+
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace Transportation{
+
+// A stop found near a point, with its distance from the point in meters.
+struct NearbyStop{
+    const Stop* stop;
+    double distance;
+};
+
+// Two stops within some distance of each other, and the distance in meters.
+struct StopPairDistance{
+    const Stop* first;
+    const Stop* second;
+    double distance;
+};
+
+// Costs of a spatial join.
+struct SpatialJoinStats{
+    size_t compared_pairs = 0; // pairs of stops the distance has been computed for
+    size_t found_pairs = 0;
+    double seconds = 0;
+};
+
+/** Finds all pairs of stops within a distance of each other. The stops are bucketed into a grid of cells as wide as the distance,
+ * so only the stops of neighbouring cells are compared, instead of every pair.
+ * @param stops Stops to join.
+ * @param max_distance The distance, in meters.
+ * @param stats If not nullptr, set to the costs of the join.
+ * @returns Every pair found, once, in no particular order.
+*/
+std::vector<StopPairDistance> JoinStopsWithinDistance(const std::vector<const Stop*>& stops, double max_distance,
+                                                      SpatialJoinStats* stats = nullptr);
+
+// A uniform latitude/longitude grid over stops, sized for a couple of stops per cell. Queries visit only the cells
+// covering the circle around the query point, and compute exact distances only for the stops in them.
+class StopSpatialIndex{
+public:
+    StopSpatialIndex() = default;
+
+    /** Builds the index.
+     * @param stops Stops to index. They must outlive the index.
+    */
+    explicit StopSpatialIndex(const std::vector<const Stop*>& stops);
+
+    /** Finds the stops within a distance from a point.
+     * @param center The point to measure the distances from.
+     * @param radius The distance, in meters.
+     * @returns Stops found, the closest first, the ones at the same distance ordered by name.
+    */
+    std::vector<NearbyStop> FindInRadius(geo::Coordinates center, double radius) const;
+
+    /** Finds the stops closest to a point.
+     * @param center The point to measure the distances from.
+     * @param count How many stops to find.
+     * @returns `count` closest stops, or all of them if there are fewer, in the order of FindInRadius.
+    */
+    std::vector<NearbyStop> FindNearest(geo::Coordinates center, size_t count) const;
+
+private:
+    size_t GetRow(double lat) const;
+    size_t GetColumn(double lng) const;
+
+    size_t rows_ = 0;
+    size_t columns_ = 0;
+    geo::Coordinates min_coordinates_{0, 0}; // the south-west corner of the grid
+    double cell_height_ = 0; // in degrees of latitude
+    double cell_width_ = 0; // in degrees of longitude
+
+    // stops of the cell in row r and column c are in [cell_offsets_[r * columns_ + c], cell_offsets_[r * columns_ + c + 1]) of cell_stops_
+    std::vector<size_t> cell_offsets_;
+    std::vector<const Stop*> cell_stops_;
+    std::vector<geo::Coordinates> cell_coordinates_; // of cell_stops_, packed for scanning
+};
+
+} // namespace Transportation
@@ -0,0 +1,54 @@
+// This file contains a simple fixed-size thread pool
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threading {
+
+// A fixed set of worker threads running batches of independent tasks.
+class ThreadPool{
+public:
+    // @param thread_count Number of threads running tasks, including the one calling ParallelFor.
+    explicit ThreadPool(size_t thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const noexcept;
+
+    /** Calls `task(i)` for every `i` in [0, task_count) and returns when all the calls have finished.
+     * The calling thread takes part in running the tasks. Tasks must not throw.
+    */
+    void ParallelFor(size_t task_count, const std::function<void(size_t)>& task);
+
+    // Number of hardware threads, but at least 1.
+    static size_t GetDefaultThreadCount() noexcept;
+
+private: // --------- HELPER METHODS ---------
+    // Takes tasks of the current batch until there are none left.
+    void RunTasks();
+    void WorkerLoop();
+
+private: // --------- FIELDS ---------
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable batch_started_;
+    std::condition_variable batch_finished_;
+
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t task_count_ = 0;
+    size_t next_task_ = 0;
+    size_t unfinished_tasks_ = 0;
+    size_t batch_number_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace threading
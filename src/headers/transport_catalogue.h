@@ -14,10 +14,15 @@
 #include <execution>
 #include <sstream>
 #include <functional>
+#include <numeric>
+#include <stdexcept>
 
 
 #include "geo.h"
 #include "domain.h"
+#include "ranges.h"
+#include "stop_distance_table.h"
+#include "stop_spatial_index.h"
 
 using namespace std::string_view_literals;
 using namespace std::string_literals;
@@ -25,16 +30,28 @@ using namespace std::string_literals;
 namespace Transportation{
 namespace detail {        
     void StripStr(std::string& str);
-
-    class StopPairHasher{
-    public:
-        size_t operator()(const std::pair<const Stop*, const Stop*> hashing_pair) const noexcept;
-    };
 } // namespace detail
 
+// A road distance set from one stop to another.
+struct StopDistance{
+    const Stop* from;
+    const Stop* to;
+    int distance;
+};
+
 class TransportCatalogue{
 public:
-    TransportCatalogue() : dummy_map_({nullptr, }) {}
+    using BusesRange = ranges::Range<std::vector<const Bus*>::const_iterator>;
+
+public: // --------- CONSTRUCTORS ---------
+    TransportCatalogue() = default;
+    // A deep copy: stops and buses keep their ids, and everything pointing at them points into the copy.
+    // The copy is not finalized, so that changing it doesn't rebuild the indices on every stop or bus added.
+    TransportCatalogue(const TransportCatalogue& other);
+    TransportCatalogue(TransportCatalogue&& other) = default; // deques keep their elements in place when moved
+    TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+    TransportCatalogue& operator=(TransportCatalogue&& other) = default;
+
 public: // --------- MODIFYING METHODS ---------
     void AddStop(std::string&& stop_name, const geo::Coordinates& coords);
 
@@ -42,49 +59,82 @@ public: // --------- MODIFYING METHODS ---------
 
     void SetStopDistance(const Stop* first_stop, const Stop* second_stop, const int distance);
 
+    // Builds the indices and the sorted views read by the querying methods, once all of the base requests are in.
+    // Adding stops or buses afterwards marks the indices outdated: the querying methods requiring them throw until
+    // the catalogue is finalized again.
+    void Finalize();
+
 public: // --------- QUERYING METHODS ---------
     BusResponse GetRoute(std::string_view bus_name) const noexcept;
 
     Stop* FindStop(std::string_view stop_name) const noexcept;
 
     int GetStopDistance(const Stop* first_stop, const Stop* second_stop) const noexcept;
+    int GetStopDistance(StopId first_stop, StopId second_stop) const noexcept;
+
+    // Ids are dense: every id below GetStopCount() / GetBusCount() is valid.
+    const Stop& GetStop(StopId id) const noexcept;
+    const Bus& GetBus(BusId id) const noexcept;
+    // Coordinates of all stops, contiguous and indexed by StopId.
+    const std::vector<geo::Coordinates>& GetStopsCoordinates() const noexcept;
+
+    // Distances as they have been set, without the ones taken from the opposite direction. In no particular order.
+    std::vector<StopDistance> GetAllStopDistances() const noexcept;
 
     size_t GetStopCount() const noexcept;
     size_t GetBusCount() const noexcept;
     
-    const std::deque<Bus*>& GetStopBusesList(const Stop* stop) noexcept;
+    // Buses passing the stop, sorted by name. Requires the catalogue to be finalized.
+    BusesRange GetStopBusesList(const Stop* stop) const;
     
-    std::vector<const Bus*> GetAllBuses() const noexcept;
-
-    std::vector<const Stop*> GetAllStops() const noexcept;
-    std::vector<const Stop*> GetUsedStops() const noexcept;
+    // Sorted by name. Require the catalogue to be finalized.
+    const std::vector<const Bus*>& GetAllBuses() const;
+    const std::vector<const Stop*>& GetAllStops() const;
+    const std::vector<const Stop*>& GetUsedStops() const; // the stops some bus passes
 
     bool StopIsUsed(const Stop* stop) const noexcept;
 
+    // Stops within `radius` meters of the point, the closest first. Requires the catalogue to be finalized.
+    std::vector<NearbyStop> FindStopsInRadius(geo::Coordinates center, double radius) const;
+    // `count` stops closest to the point, the closest first. Requires the catalogue to be finalized.
+    std::vector<NearbyStop> FindNearestStops(geo::Coordinates center, size_t count) const;
+
 private: // --------- HELPER METHODS ---------
-    static double CountRouteLength(const std::vector<Stop*>& stops, const bool round_route){
-        double route_length = 0;
-        int stops_amount = stops.size();
+    // Updates the statistics kept in the bus that depend on its stops and road distances.
+    void UpdateBusStats(Bus& bus) const;
+
+    void BuildIndices();
 
-        if (stops_amount < 2){
+    void CheckFinalized() const;
+
+    double CountRouteLength(const std::vector<StopId>& stops, const bool round_route) const{
+        if (stops.size() < 2){
             return 0;
         }
-        for (int i = 0; i <= stops_amount - 2; ++i){
-            route_length += geo::ComputeDistance(stops[i]->coordinates, stops[i + 1]->coordinates);
-        }
+        std::vector<double> distances(stops.size() - 1);
+        geo::ComputePathDistances(stop_prepared_coordinates_.data(), stops.data(), stops.size(), distances.data());
+        const double route_length = std::accumulate(distances.begin(), distances.end(), 0.0);
 
         return round_route == false ? route_length * 2 : route_length;
     }
 
 private:// --------- FIELDS ---------
-    std::deque<Stop> stops_;
-    std::deque<Bus> buses_;
+    std::deque<Stop> stops_; // indexed by StopId
+    std::deque<Bus> buses_; // indexed by BusId
+    std::vector<geo::Coordinates> stop_coordinates_; // indexed by StopId
+    std::vector<geo::PreparedCoordinates> stop_prepared_coordinates_; // indexed by StopId
     std::unordered_map<std::string_view, Stop*> stopname_to_stop_;
     std::unordered_map<std::string_view, Bus*> busname_to_bus_;
-    std::unordered_map<const Stop*, std::deque<Bus*>> stop_to_buses_;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, detail::StopPairHasher> stoppair_to_distance_;
-
-    std::deque<Bus*> dummy_map_;
+    std::vector<std::deque<Bus*>> stop_to_buses_; // indexed by StopId, in the order of insertion
+    // buses of the stop with id i, sorted by name, are in [stop_buses_offsets_[i], stop_buses_offsets_[i + 1]) of stop_buses_
+    std::vector<size_t> stop_buses_offsets_;
+    std::vector<const Bus*> stop_buses_;
+    std::vector<const Stop*> sorted_stops_;
+    std::vector<const Stop*> used_stops_; // sorted by name
+    std::vector<const Bus*> sorted_buses_;
+    StopSpatialIndex stops_index_;
+    bool is_finalized_ = false; // the indices are built and up to date
+    StopDistanceTable stoppair_to_distance_;
 };
 
 } // namespace Transportation
\ No newline at end of file
@@ -1,22 +1,51 @@
 #pragma once
 
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy_router.h"
+#include "route_cache.h"
 #include "transport_catalogue.h"
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <tuple>
+
 namespace Transportation{
 
+// Graph routing algorithm used to answer route requests.
+enum class RouterBackend{
+    ALL_PAIRS, // precomputes every route on build (Floyd-Warshall), O(V^2) memory
+    ALL_PAIRS_COMPACT, // same as ALL_PAIRS with a 4 times smaller table of float weights, which may pick a route a rounding error heavier
+    DIJKSTRA, // searches routes on demand, O(V + E) memory
+    A_STAR, // on-demand search directed towards the destination stop by geographical distance
+    BIDIRECTIONAL, // on-demand search from both the departure and the destination stops
+    CONTRACTION_HIERARCHY, // searches routes on demand over a precomputed hierarchy of shortcuts
+    RAPTOR // searches routes on demand round by round over bus stop sequences, no graph is built
+};
+
 struct RouterConfig{
     double bus_velocity = 0;
     int bus_wait_time = 0;
+    RouterBackend backend = RouterBackend::ALL_PAIRS;
+    size_t route_cache_size = 0; // bytes for routes from recently queried stops (on-demand backends), 0 disables the cache
+    std::string snapshot_file; // a file the built routes are mapped from and saved to (all-pairs backends), empty for none
+    double walking_speed = 0; // km/h; stops closer than max_walk_distance are joined by walks if both are positive
+    double max_walk_distance = 0; // meters, as the crow flies
+
+    bool HasWalking() const{
+        return walking_speed > 0 && max_walk_distance > 0;
+    }
 };
 
 enum class RouteItemType{
-    WAIT, BUS
+    WAIT, BUS, WALK
 };
 
 struct RouteItem{
     RouteItemType type;
-    std::string_view name;
+    std::string_view name; // of the stop waited at or walked to, or of the bus
     int span_count;
     double spent_time;
 };
@@ -26,27 +55,315 @@ struct RouteResponse{
     std::string error = "N/A"; // for debugging purpuses
     double total_time = 0.0;
     std::vector<RouteItem> route_items;
+    // Vertices the graph search has settled, 0 for backends not searching at query time (all-pairs, RAPTOR, snapshots)
+    // and for routes taken from the route cache.
+    size_t settled_vertices = 0;
+};
+
+// Costs of an in-place router update, to compare with the time of building the router.
+struct RouterUpdateStats{
+    size_t added_edges = 0;
+    size_t removed_edges = 0;
+    // The backend preprocessing could not be updated in place, so it has been built anew. Always the case for
+    // RouterBackend::CONTRACTION_HIERARCHY: an edge change may reorder the contraction, so the hierarchy is not patched.
+    bool rebuilt = false;
+    size_t invalidated_trees = 0; // cached shortest path trees the change has affected
+    double seconds = 0;
+};
+
+// Costs of joining nearby stops by walks.
+struct WalkingTransferStats{
+    size_t compared_pairs = 0; // pairs of stops the distance has been computed for
+    size_t walking_edges = 0; // both directions of a walk counted
+    double seconds = 0;
+};
+
+constexpr static const double KMH_TO_MM_COEF = 100.0 / 6.0; // km/h to m/min
+
+// Round-based (RAPTOR) route search. Works on stop sequences of buses instead of a graph with an edge for every
+// pair of stops on a bus, so memory is linear in the total length of routes. Round k finds the fastest arrivals
+// with k rides, which also makes it a multi-criteria (travel time, transfers) search.
+// Query buffers are kept between queries (not thread-safe).
+class RaptorRouter{
+public:
+    /**
+     * @param config A configuration structure for the transport router.
+     * @param transp_db A transport database.
+    */
+    RaptorRouter(const RouterConfig& config, const TransportCatalogue& transp_db);
+
+    /** Finds the fastest route from one stop to another.
+     * @param stop_from A stop to build a route from.
+     * @param stop_to A stop to build a route to.
+     * @returns A response in a form of RouteResponse struct.
+    */
+    RouteResponse FindRoute(std::string_view stop_from, std::string_view stop_to) const;
+
+    /** Finds the Pareto front of routes by travel time and number of transfers: the fastest route for each number of
+     * transfers, as long as it is faster than every route with fewer transfers.
+     * @param stop_from A stop to build routes from.
+     * @param stop_to A stop to build routes to.
+     * @returns Routes ordered by the number of transfers, empty if the stops are unknown or unconnected.
+    */
+    std::vector<RouteResponse> FindParetoRoutes(std::string_view stop_from, std::string_view stop_to) const;
+
+    /** Computes the fastest travel times from one stop to several others with a single search.
+     * @param stop_from A stop to start from.
+     * @param stops_to Stops to compute travel times to.
+     * @returns Travel times in the order of `stops_to`, std::nullopt for unknown or unreachable stops.
+    */
+    std::vector<std::optional<double>> ComputeTimes(std::string_view stop_from, const std::vector<std::string_view>& stops_to) const;
+
+    /** Finds stops reachable from a stop within a time limit, with a single search cut off at the limit.
+     * @param stop_from A stop to start from.
+     * @param max_time A time limit, in minutes.
+     * @returns Reachable stops with the fastest travel times to them, std::nullopt if `stop_from` is unknown.
+    */
+    std::optional<std::vector<std::pair<std::string_view, double>>> FindReachableStops(std::string_view stop_from, double max_time) const;
+
+    bool HasStop(std::string_view stop_name) const;
+    bool HasBus(std::string_view bus_name) const;
+
+    /** Adds a stop with no buses passing it yet.
+     * @param stop A stop of the transport database. Must outlive the router.
+     * @throws std::logic_error if the stop has already been added.
+    */
+    void AddStop(const Stop* stop);
+
+    /** Adds the stop sequences of a bus.
+     * @param bus A bus of the transport database, all of its stops added to the router. Must outlive the router.
+     * @param transp_db A transport database to get road distances from.
+     * @throws std::logic_error if the bus has already been added.
+    */
+    void AddBus(const Bus* bus, const TransportCatalogue& transp_db);
+
+    /** Removes the stop sequences of a bus.
+     * @param bus_name A name of a bus added to the router.
+     * @throws std::logic_error if the bus is unknown.
+    */
+    void RemoveBus(std::string_view bus_name);
+
+    // Costs of joining the stops by walks, including the stops added since construction.
+    const WalkingTransferStats& GetWalkingTransferStats() const{
+        return walking_stats_;
+    }
+
+private:
+    static constexpr size_t NO_LEG = static_cast<size_t>(-1);
+    static constexpr size_t NO_POSITION = static_cast<size_t>(-1);
+    static constexpr size_t NO_PATTERN = static_cast<size_t>(-1);
+
+    // A bus ride direction: a sequence of stops along with road distances from its first stop.
+    struct Pattern{
+        const Bus* bus;
+        size_t offset; // of the pattern's stops in pattern_stops_ and pattern_distances_
+        size_t stops_count;
+        bool is_removed = false; // along with the bus, the pattern is kept so that ids of the others stay valid
+    };
+
+    // A ride of a journey, from one pattern position to a later one, or a walk between two stops.
+    struct Leg{
+        size_t pattern; // NO_PATTERN for a walk, whose positions are then the stops walked from and to
+        size_t board_position;
+        size_t alight_position;
+        size_t prev_leg; // the previous ride of the journey or NO_LEG
+    };
+
+    // An arrival at a stop in some round, along with the last ride of the journey.
+    struct Label{
+        double arrival;
+        size_t leg;
+    };
+
+    // Adds walks from a stop to the stops within walking distance, and back.
+    void AddStopFootpaths(size_t stop);
+
+    // Relaxes walks from the stops marked in a round, and from the ones the walks improve, as on a graph.
+    void RelaxFootpaths(size_t round, std::optional<size_t> target) const;
+
+    // Adds patterns of both directions of a bus.
+    void AddBusPatterns(const Bus* bus, const TransportCatalogue& transp_db);
+
+    /** Adds a pattern of stops, skipping ones with nowhere to ride.
+     * @param bus A bus the pattern belongs to.
+     * @param stops Stops of the pattern in the riding order.
+     * @param transp_db A transport database to get road distances from.
+     * @param bus_patterns Ids of the bus patterns to add the pattern id to.
+    */
+    void AddPattern(const Bus* bus, const std::vector<StopId>& stops, const TransportCatalogue& transp_db,
+                    std::vector<size_t>& bus_patterns);
+
+    // Packs patterns passing every stop, skipping removed ones, and sizes query buffers to the stops and patterns.
+    void IndexPatterns();
+
+    // Runs rounds from `source` until no arrival improves. Arrivals later than the one at `target` or than `max_arrival`
+    // are pruned, as well as arrivals later than ones with fewer rides.
+    void RunRounds(size_t source, std::optional<size_t> target,
+                   double max_arrival = std::numeric_limits<double>::infinity()) const;
+
+    // Scans a pattern from `first_position`, boarding at stops reached in the previous round and improving arrivals down the line.
+    void ScanPattern(size_t pattern, size_t first_position, size_t round, std::optional<size_t> target) const;
+
+    // The latest arrival worth labeling: the arrival at `target` if there is one, within the limit of the current query.
+    double GetArrivalBound(std::optional<size_t> target) const;
+
+    double GetRideTime(const Pattern& pattern, size_t board_position, size_t alight_position) const;
+
+    // Converts a journey ending with `label` into a response.
+    RouteResponse MakeResponse(const Label& label) const;
+
+    const double meters_per_minute_;
+    const double wait_time_;
+    const double walking_meters_per_minute_; // 0 if walking is disabled
+    const double max_walk_distance_;
+
+    std::vector<const Stop*> stops_;
+    std::unordered_map<std::string_view, size_t> stopname_to_index_;
+    std::vector<size_t> stopid_to_index_; // indexed by StopId
+    std::vector<std::vector<std::pair<size_t, double>>> footpaths_; // stops within walking distance of every stop, with walking times
+    WalkingTransferStats walking_stats_;
+
+    std::vector<Pattern> patterns_;
+    std::unordered_map<std::string_view, std::vector<size_t>> bus_patterns_; // names are owned by the catalogue
+    std::vector<size_t> pattern_stops_;
+    std::vector<double> pattern_distances_;
+
+    // Patterns passing every stop with the stop's positions on them, packed by stop.
+    std::vector<size_t> stop_patterns_offsets_;
+    std::vector<std::pair<size_t, size_t>> stop_patterns_;
+
+    mutable std::vector<std::vector<Label>> round_labels_; // a pool of label arrays, one per round, reused by queries
+    mutable size_t round_count_ = 0; // rounds run by the last query
+    mutable double arrival_limit_ = 0; // arrivals of the current query must be earlier
+    mutable std::vector<double> best_arrivals_; // over all rounds run so far
+    mutable std::vector<Leg> legs_;
+    mutable std::vector<size_t> marked_stops_;
+    mutable std::vector<bool> is_marked_;
+    mutable std::vector<size_t> first_positions_; // positions to scan patterns from in the current round
+    mutable std::vector<size_t> queued_patterns_;
+    mutable std::vector<std::pair<double, size_t>> walk_queue_; // a heap of arrivals by walking, for RelaxFootpaths
+};
+
+// Precomputed all-pairs routes, saved to a binary file and served right from its memory-mapped pages: queries need
+// no deserialization, startup maps the file instead of building the graph, and processes mapping the same file share
+// its physical memory. The file is versioned and stamped with a fingerprint of the data it has been built from.
+class RouterSnapshot{
+public:
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t VERSION = 2;
+
+    /** Writes a snapshot file. The file is written aside and renamed, so processes never map a partial one.
+     * @param path A file to write.
+     * @param fingerprint A fingerprint of the data the routes have been built from.
+     * @param stop_names Stop names by vertex id / 2.
+     * @param edge_items Route items by edge id.
+     * @param graph The graph the routes have been built on.
+     * @param prev_edges The last edges of all-pairs routes over the graph, by `from * vertex_count + to`, NO_EDGE for none.
+     * @param weights Weights of the routes, in the same order, as the router has computed them. If empty, the weights
+     * of mapped routes are summed up by their edges, the way routers with inexact route tables do.
+     * @throws std::runtime_error if the file cannot be written.
+    */
+    static void Write(const std::string& path, uint64_t fingerprint, const std::vector<std::string_view>& stop_names,
+                      const std::vector<RouteItem>& edge_items, const graph::CsrGraph<double>& graph,
+                      const std::vector<uint32_t>& prev_edges, const std::vector<double>& weights);
+
+    /** Maps a snapshot file.
+     * @param path A file to map.
+     * @param fingerprint A fingerprint of the data the routes are expected to be built from.
+     * @returns The mapped snapshot, or nullptr if the file is missing, malformed, of another version or built from other data.
+    */
+    static std::unique_ptr<RouterSnapshot> Open(const std::string& path, uint64_t fingerprint);
+
+    // A hash of everything the routes depend on: routing settings, stops, buses and road distances along them.
+    static uint64_t ComputeFingerprint(const RouterConfig& config, const TransportCatalogue& transp_db);
+
+    RouterSnapshot(const RouterSnapshot&) = delete;
+    RouterSnapshot& operator=(const RouterSnapshot&) = delete;
+    ~RouterSnapshot();
+
+    // Same as Router::FindRoute.
+    RouteResponse FindRoute(std::string_view stop_from, std::string_view stop_to) const;
+
+    // Travel times from one stop to others, std::nullopt for unknown or unreachable stops.
+    std::vector<std::optional<double>> ComputeTimes(std::string_view stop_from, const std::vector<std::string_view>& stops_to) const;
+
+    // Stops reachable within `max_time` along with travel times to them, std::nullopt if `stop_from` is unknown.
+    std::optional<std::vector<std::pair<std::string_view, double>>> FindReachableStops(std::string_view stop_from, double max_time) const;
+
+private:
+    struct Header;
+    struct NameRef;
+    struct EdgeRecord;
+
+    RouterSnapshot() = default;
+
+    std::string_view GetName(const NameRef& name) const;
+    std::optional<uint32_t> FindStop(std::string_view stop_name) const;
+    // Edges of the route between two vertices, from the last one to the first, or std::nullopt if there is no route.
+    std::optional<std::vector<uint32_t>> CollectRouteEdges(uint64_t from, uint64_t to) const;
+    std::optional<double> ComputeTime(uint64_t from, uint64_t to) const;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<char> buffer_; // the file contents where it cannot be mapped
+
+    const Header* header_ = nullptr;
+    const NameRef* stop_names_ = nullptr; // by stop index, which is vertex id / 2
+    const uint32_t* sorted_stops_ = nullptr; // stop indices in the order of their names
+    const EdgeRecord* edges_ = nullptr;
+    const uint32_t* prev_edges_ = nullptr; // of the route table
+    const double* weights_ = nullptr; // of the route table, nullptr if they are summed up by edges
+    const char* names_ = nullptr;
 };
 
 // Transportatin Router class.
 class Router{
 public:
     using Graph = graph::DirectedWeightedGraph<double>;
-    using InRouter = graph::Router<double>;
+    using FrozenGraph = graph::CsrGraph<double>;
+    using InRouter = graph::RouterBase<double>;
     using Edge = graph::Edge<double>;
+    using AllPairsRouter = graph::Router<double>;
+    using CompactAllPairsRouter = graph::Router<double, graph::CompactRouteTable<double>>;
     /**
      * @param config A configuration structure for the transport router.
      * @param transp_db A transport database.
     */
-    Router(RouterConfig&& config, const TransportCatalogue& transp_db) : config_(std::move(config)) {
-        BuildGraph(transp_db);
-    }
+    Router(RouterConfig&& config, const TransportCatalogue& transp_db);
 
     /** Main router building method. Builds a graph with stops and routes.
      * @param transp_db A transport database to build from
     */
     void BuildGraph(const TransportCatalogue& transp_db);
-    
+
+    // Seconds the last BuildGraph call has taken, or the snapshot file has taken to map.
+    double GetBuildSeconds() const{
+        return build_seconds_;
+    }
+
+    /** Adds a stop to the built router in place.
+     * @param stop A stop of the transport database the router has been built from.
+     * @returns Costs of the update.
+     * @throws std::logic_error if the stop has already been added or the router is served from a snapshot.
+    */
+    RouterUpdateStats AddStop(const Stop* stop);
+
+    /** Adds the routes of a bus to the built router in place. Stops of the bus unknown to the router are added as well.
+     * Only the routes the bus makes faster are recomputed, while other backend data is kept.
+     * @param bus A bus of the transport database the router has been built from.
+     * @param transp_db The transport database, to get road distances from.
+     * @returns Costs of the update.
+     * @throws std::logic_error if the bus has already been added or the router is served from a snapshot.
+    */
+    RouterUpdateStats AddBus(const Bus* bus, const TransportCatalogue& transp_db);
+
+    /** Removes the routes of a bus from the built router in place. Only the routes that have used the bus are recomputed.
+     * @param bus_name A name of a bus known to the router.
+     * @returns Costs of the update.
+     * @throws std::logic_error if the bus is unknown or the router is served from a snapshot.
+    */
+    RouterUpdateStats RemoveBus(std::string_view bus_name);
+
     /** Finds the shortest route from one stop to another.
      * @param stop_from A stop to build a route from.
      * @param stop_to A stop to build a route to.
@@ -54,9 +371,42 @@ public:
     */
     RouteResponse FindRoute(const std::string& stop_from, const std::string& stop_to);
 
+    /** Finds the fastest route for each number of transfers that makes a route faster than ones with fewer transfers.
+     * @param stop_from A stop to build routes from.
+     * @param stop_to A stop to build routes to.
+     * @returns Routes ordered by the number of transfers, empty if there are none.
+    */
+    std::vector<RouteResponse> FindParetoRoutes(const std::string& stop_from, const std::string& stop_to) const;
+
+    /** Finds stops reachable from a stop within a time limit, with a single search cut off at the limit.
+     * @param stop_from A stop to start from.
+     * @param max_time A time limit, in minutes.
+     * @returns Reachable stops with the fastest travel times to them, ordered by the times, std::nullopt if `stop_from` is unknown.
+    */
+    std::optional<std::vector<std::pair<std::string_view, double>>> FindReachableStops(const std::string& stop_from, double max_time);
+
+    /** Computes a matrix of the fastest travel times between two sets of stops, with one search per departure stop.
+     * @param stops_from Stops to depart from, one per matrix row.
+     * @param stops_to Stops to arrive to, one per matrix column.
+     * @returns Travel times, std::nullopt for unknown or unreachable stops.
+    */
+    std::vector<std::vector<std::optional<double>>> ComputeTimeMatrix(const std::vector<std::string_view>& stops_from,
+                                                                      const std::vector<std::string_view>& stops_to);
+
+    // Counters of the route cache, or std::nullopt if the cache is disabled.
+    std::optional<graph::RouteCacheStats> GetRouteCacheStats() const;
+
+    // Costs of joining stops by walks when the router has been built, including the stops added since, or std::nullopt if walking is disabled.
+    std::optional<WalkingTransferStats> GetWalkingTransferStats() const;
+
+    // True if routes are served from a mapped snapshot file instead of a built graph.
+    bool IsServedFromSnapshot() const{
+        return snapshot_ != nullptr;
+    }
+
 private:
-    constexpr static const double KMH_TO_MM_COEF = 100.0 / 6.0;
-    
+    static constexpr graph::VertexId NO_VERTEX = std::numeric_limits<graph::VertexId>::max();
+
     /** Creates edges for stops (arrival and boarding vertecies)
      * @param stops A vector containing pointers to stops.
      * @param init_graph A graph to create edges on.
@@ -70,12 +420,67 @@ private:
     */
     void CreateRouteEdges(const TransportCatalogue& transp_db, const std::vector<const Bus*>& buses, Graph& init_graph);
 
+    /** Creates walk edges in both directions between arrival vertices of stops within walking distance of each other.
+     * @param stops Stops to join, all of them already in the graph.
+     * @param init_graph A graph to create walk edges on.
+    */
+    void CreateWalkEdges(const std::vector<const Stop*>& stops, Graph& init_graph);
+
+    // Creates a walk edge between arrival vertices of two stops, with its route item; `distance` is in meters.
+    void AddWalkEdge(graph::VertexId from, graph::VertexId to, double distance, Graph& init_graph);
+
+    // Throws if the router cannot be updated in place.
+    void CheckUpdatable() const;
+
+    // Adds vertices and the wait edge of a stop to the graph being updated.
+    void AddStopToGraph(const Stop* stop);
+
+    /** Refreezes the updated graph and brings the graph router and the route cache in line with the edges added since
+     * the last update, and the removed ones.
+     * @param removed_edges Edges removed since the last update.
+     * @param stats Update costs to fill in.
+    */
+    void UpdateGraph(const std::vector<graph::EdgeId>& removed_edges, RouterUpdateStats& stats);
+
+    // Stores a route item of the edge just added to the graph, which may have taken the id of a removed one.
+    void AddEdgeItem(graph::EdgeId eid, const RouteItem& item);
+
+    // Creates a graph router of the configured backend over the built graph.
+    std::unique_ptr<InRouter> CreateInRouter() const;
+
+    // Writes the routes precomputed by an all-pairs backend to the snapshot file.
+    void WriteSnapshot(uint64_t fingerprint) const;
+
+    /** A lower bound of the travel time between two vertices, based on the geographical distance between their stops.
+     * Consistent as long as no bus is faster than the fastest stop-to-stop ride on the graph.
+    */
+    double ComputeTimeLowerBound(graph::VertexId from, graph::VertexId to) const;
+
+    /** Builds a route over the graph, through the route cache if it is enabled.
+     * @param settled_count Set to the number of vertices settled by the search, 0 if the route has been taken from the cache.
+    */
+    std::optional<InRouter::RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to, size_t& settled_count);
+
     RouterConfig config_;
-    Graph graph_;
+    std::unique_ptr<RaptorRouter> raptor_; // answers multi-criteria requests, and replaces the graph for RouterBackend::RAPTOR
+    Graph init_graph_; // kept for in-place updates, which are refrozen into graph_
+    FrozenGraph graph_; // the built graph, packed for searches
     std::unique_ptr<InRouter> router_;
+    std::unique_ptr<graph::RouteCache<double>> route_cache_; // shortest path trees of recently queried departure stops
+    std::unique_ptr<RouterSnapshot> snapshot_; // replaces the graph when the routes have been mapped from a file
+
+    std::vector<geo::Coordinates> vid_to_coordinates_;
+    double min_minutes_per_meter_ = 0; // the fastest ride on the graph, relative to the geographical distance
+
+    std::unordered_map<std::string_view, graph::VertexId> stopname_to_vid_; // names are owned by the catalogue
+    std::vector<graph::VertexId> stopid_to_vid_; // indexed by StopId, NO_VERTEX for stops not in the graph
+    std::vector<RouteItem> edge_items_; // indexed by graph::EdgeId
+    std::vector<graph::EdgeId> added_edges_; // added since the graph router has been built or updated
+    std::vector<std::string_view> stop_names_; // indexed by vertex id / 2
+    std::unordered_map<std::string_view, std::vector<graph::EdgeId>> bus_edges_; // ids of a bus's edges, not contiguous once ids get reused
 
-    std::unordered_map<std::string, graph::VertexId> stopname_to_vid_;
-    std::unordered_map<graph::EdgeId, RouteItem> edgeid_to_item_;
+    double build_seconds_ = 0;
+    WalkingTransferStats walking_stats_;
 
 };
 
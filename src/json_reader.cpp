@@ -1,7 +1,7 @@
 #include "headers/json_reader.h"
 
 /* --------- TC_QueryHandler CONSTRUCTOR --------- */
-TC_QueryHandler::TC_QueryHandler(Transportation::TransportCatalogue& transp_catalogue) : db_(transp_catalogue) {
+TC_QueryHandler::TC_QueryHandler(){
     stat_reqs_output_.reserve(50);
 }
 
@@ -13,28 +13,28 @@ void TC_QueryHandler::AddBus(const json::Dict& bus){
     base_bus_reqs.push_back(bus);
 }
 
-void TC_QueryHandler::ProcessBaseRequests(){
+void TC_QueryHandler::ProcessBaseRequests(Transportation::TransportCatalogue& transp_catalogue){
     std::deque<std::tuple<Stop*, std::string_view, int>> stops_to_distance;
     for (const json::Dict& stop : base_stop_reqs){
         std::string stop_name = stop.at("name").AsString();
         geo::Coordinates stop_coords{stop.at("latitude").AsDouble(), stop.at("longitude").AsDouble()};
-        db_.AddStop(std::string(stop_name), std::move(stop_coords));
-        Stop* stop_ptr = db_.FindStop(stop_name);
+        transp_catalogue.AddStop(std::string(stop_name), std::move(stop_coords));
+        Stop* stop_ptr = transp_catalogue.FindStop(stop_name);
 
         for (const auto& [name, dist] : stop.at("road_distances").AsDict()){
             std::string_view road_stop_name(name);
-            Stop* stop2_ptr = db_.FindStop(name);
+            Stop* stop2_ptr = transp_catalogue.FindStop(name);
             if (!stop2_ptr){
                 stops_to_distance.push_back({stop_ptr, road_stop_name, dist.AsInt()});
                 continue;
             }
-            db_.SetStopDistance(stop_ptr, stop2_ptr, static_cast<uint32_t>(dist.AsInt()));
+            transp_catalogue.SetStopDistance(stop_ptr, stop2_ptr, static_cast<uint32_t>(dist.AsInt()));
         }
     }
     for (const auto& [stop1_ptr, stop2_name, dist] : stops_to_distance){
-        Stop* stop2_ptr = db_.FindStop(stop2_name);
+        Stop* stop2_ptr = transp_catalogue.FindStop(stop2_name);
         if (stop2_ptr){
-            db_.SetStopDistance(stop1_ptr, stop2_ptr, static_cast<uint32_t>(dist));
+            transp_catalogue.SetStopDistance(stop1_ptr, stop2_ptr, static_cast<uint32_t>(dist));
         }
     }
 
@@ -45,14 +45,19 @@ void TC_QueryHandler::ProcessBaseRequests(){
         bus_stops.reserve(stop_arr.size());
 
         for (const json::Node& stop_node : stop_arr){
-            Stop* stop_ptr = db_.FindStop(std::string_view(stop_node.AsString()));
+            Stop* stop_ptr = transp_catalogue.FindStop(std::string_view(stop_node.AsString()));
             bus_stops.push_back(stop_ptr);
         }
-        db_.AddBus(std::move(bus_name), std::move(bus_stops), bus.at("is_roundtrip").AsBool());
+        transp_catalogue.AddBus(std::move(bus_name), std::move(bus_stops), bus.at("is_roundtrip").AsBool());
     }
+    transp_catalogue.Finalize();
 }
 
 /* --------- STAT REQUESTS HANDLING --------- */
+void TC_QueryHandler::SetCatalogue(Transportation::CatalogueSnapshot catalogue){
+    db_ = std::move(catalogue);
+}
+
 void TC_QueryHandler::AddStatStopRequest(const json::Dict& stop_req){
     using namespace json;
 
@@ -61,9 +66,9 @@ void TC_QueryHandler::AddStatStopRequest(const json::Dict& stop_req){
     int id = stop_req.at("id").AsInt();
     
     std::string_view stop_name(stop_req.at("name").AsString());
-    Stop* found_stop = db_.FindStop(stop_name);
+    const Stop* found_stop = db_->FindStop(stop_name);
     if (found_stop){
-        const std::deque<Bus*> bus_list = db_.GetStopBusesList(found_stop);
+        const Transportation::TransportCatalogue::BusesRange bus_list = db_->GetStopBusesList(found_stop);
         Array stop_buses;
         stop_buses.reserve(bus_list.size());
         for (const Bus* bus : bus_list){
@@ -91,7 +96,7 @@ void TC_QueryHandler::AddStatBusRequest(const json::Dict& bus_req){
     int id = bus_req.at("id").AsInt();
 
     std::string_view bus_name(bus_req.at("name").AsString());
-    BusResponse found_bus = db_.GetRoute(bus_name);
+    BusResponse found_bus = db_->GetRoute(bus_name);
     if (found_bus.success){
         req_dict_builder.StartDict()
                             .Key("curvature").Value(found_bus.C_route_length)
@@ -111,6 +116,40 @@ void TC_QueryHandler::AddStatBusRequest(const json::Dict& bus_req){
     stat_reqs_output_.push_back(Node{std::move(req_dict_builder.Build())});
 }
 
+json::Array TC_QueryHandler::BuildRouteItems(const Transportation::RouteResponse& resp){
+    using namespace json;
+
+    Array route_items;
+    route_items.reserve(resp.route_items.size());
+    for (const Transportation::RouteItem& item : resp.route_items){
+        Builder item_builder;
+        if (item.type == Transportation::RouteItemType::WAIT){
+            item_builder.StartDict()
+                            .Key("type").Value("Wait")
+                            .Key("stop_name").Value(std::string(item.name))
+                            .Key("time").Value(item.spent_time)
+                        .EndDict();
+        }
+        else if (item.type == Transportation::RouteItemType::BUS){
+            item_builder.StartDict()
+                            .Key("type").Value("Bus")
+                            .Key("bus").Value(std::string(item.name))
+                            .Key("span_count").Value(item.span_count)
+                            .Key("time").Value(item.spent_time)
+                        .EndDict();
+        }
+        else if (item.type == Transportation::RouteItemType::WALK){
+            item_builder.StartDict()
+                            .Key("type").Value("Walk")
+                            .Key("stop_name").Value(std::string(item.name))
+                            .Key("time").Value(item.spent_time)
+                        .EndDict();
+        }
+        route_items.push_back(Node{std::move(item_builder.Build())});
+    }
+    return route_items;
+}
+
 void TC_QueryHandler::AddStatRouteRequest(const json::Dict& route_req, const std::unique_ptr<Transportation::Router>& router){
     using namespace json;
 
@@ -119,6 +158,38 @@ void TC_QueryHandler::AddStatRouteRequest(const json::Dict& route_req, const std
     std::string stop_from = route_req.at("from").AsString();
     std::string stop_to = route_req.at("to").AsString();
 
+    if (route_req.count("pareto") && route_req.at("pareto").AsBool()){
+        const std::vector<Transportation::RouteResponse> routes = router->FindParetoRoutes(stop_from, stop_to);
+        if (routes.empty()){
+            route_resp_builder.StartDict()
+                                .Key("request_id").Value(id)
+                                .Key("error_message").Value("not found")
+                            .EndDict();
+        }
+        else{
+            Array route_options;
+            route_options.reserve(routes.size());
+            for (const Transportation::RouteResponse& route : routes){
+                const int bus_count = std::count_if(route.route_items.begin(), route.route_items.end(), [](const Transportation::RouteItem& item){
+                    return item.type == Transportation::RouteItemType::BUS;
+                });
+                Builder option_builder;
+                option_builder.StartDict()
+                                .Key("items").Value(BuildRouteItems(route))
+                                .Key("total_time").Value(route.total_time)
+                                .Key("transfers").Value(std::max(bus_count - 1, 0))
+                            .EndDict();
+                route_options.push_back(Node{std::move(option_builder.Build())});
+            }
+            route_resp_builder.StartDict()
+                                .Key("request_id").Value(id)
+                                .Key("routes").Value(std::move(route_options))
+                            .EndDict();
+        }
+        stat_reqs_output_.push_back(Node{std::move(route_resp_builder.Build())});
+        return;
+    }
+
     Transportation::RouteResponse resp = router->FindRoute(stop_from, stop_to);
     if (!resp.success){
         route_resp_builder.StartDict()
@@ -127,39 +198,121 @@ void TC_QueryHandler::AddStatRouteRequest(const json::Dict& route_req, const std
                         .EndDict();
     }
     else{
-        Array route_items;
-        route_items.reserve(resp.route_items.size());
-        for (const Transportation::RouteItem& item : resp.route_items){
-            Builder item_builder;
-            if (item.type == Transportation::RouteItemType::WAIT){
-                item_builder.StartDict()
-                                .Key("type").Value("Wait")
-                                .Key("stop_name").Value(std::string(item.name))
-                                .Key("time").Value(item.spent_time)
-                            .EndDict();
-            }
-            else if (item.type == Transportation::RouteItemType::BUS){
-                item_builder.StartDict()
-                                .Key("type").Value("Bus")
-                                .Key("bus").Value(std::string(item.name))
-                                .Key("span_count").Value(item.span_count)
-                                .Key("time").Value(item.spent_time)
-                            .EndDict();
-            }
-            route_items.push_back(Node{std::move(item_builder.Build())});
+        Builder::DictContext resp_dict = route_resp_builder.StartDict()
+                                                            .Key("request_id").Value(id)
+                                                            .Key("total_time").Value(resp.total_time)
+                                                            .Key("items").Value(BuildRouteItems(resp));
+        if (route_req.count("debug") && route_req.at("debug").AsBool()){
+            resp_dict.Key("settled_vertices").Value(static_cast<int>(resp.settled_vertices));
         }
-
-        route_resp_builder.StartDict()
-                            .Key("request_id").Value(id)
-                            .Key("total_time").Value(resp.total_time)
-                            .Key("items").Value(std::move(route_items))
-                        .EndDict();
+        resp_dict.EndDict();
     }
 
     stat_reqs_output_.push_back(Node{std::move(route_resp_builder.Build())});
     
 }
 
+void TC_QueryHandler::AddStatMatrixRequest(const json::Dict& matrix_req, const std::unique_ptr<Transportation::Router>& router){
+    using namespace json;
+
+    Builder matrix_resp_builder;
+    int id = matrix_req.at("id").AsInt();
+    const auto read_stops = [](const Array& stop_nodes){
+        std::vector<std::string_view> stops;
+        stops.reserve(stop_nodes.size());
+        for (const Node& stop_node : stop_nodes){
+            stops.emplace_back(stop_node.AsString());
+        }
+        return stops;
+    };
+
+    const std::vector<std::vector<std::optional<double>>> matrix = router->ComputeTimeMatrix(read_stops(matrix_req.at("from").AsArray()),
+                                                                                            read_stops(matrix_req.at("to").AsArray()));
+    Array times;
+    times.reserve(matrix.size());
+    for (const std::vector<std::optional<double>>& row : matrix){
+        Array row_times;
+        row_times.reserve(row.size());
+        for (const std::optional<double>& time : row){
+            row_times.push_back(time ? Node{*time} : Node{nullptr});
+        }
+        times.push_back(Node{std::move(row_times)});
+    }
+
+    matrix_resp_builder.StartDict()
+                        .Key("request_id").Value(id)
+                        .Key("times").Value(std::move(times))
+                    .EndDict();
+    stat_reqs_output_.push_back(Node{std::move(matrix_resp_builder.Build())});
+}
+
+void TC_QueryHandler::AddStatIsochroneRequest(const json::Dict& isochrone_req, const std::unique_ptr<Transportation::Router>& router){
+    using namespace json;
+
+    Builder isochrone_resp_builder;
+    int id = isochrone_req.at("id").AsInt();
+    std::string stop_from = isochrone_req.at("from").AsString();
+
+    const auto reachable = router->FindReachableStops(stop_from, isochrone_req.at("max_time").AsDouble());
+    if (!reachable){
+        isochrone_resp_builder.StartDict()
+                                .Key("request_id").Value(id)
+                                .Key("error_message").Value("not found")
+                            .EndDict();
+    }
+    else{
+        Array stops;
+        stops.reserve(reachable->size());
+        for (const auto& [stop_name, time] : *reachable){
+            Builder stop_builder;
+            stop_builder.StartDict()
+                            .Key("stop_name").Value(std::string(stop_name))
+                            .Key("time").Value(time)
+                        .EndDict();
+            stops.push_back(Node{std::move(stop_builder.Build())});
+        }
+        isochrone_resp_builder.StartDict()
+                                .Key("request_id").Value(id)
+                                .Key("stops").Value(std::move(stops))
+                            .EndDict();
+    }
+
+    stat_reqs_output_.push_back(Node{std::move(isochrone_resp_builder.Build())});
+}
+
+void TC_QueryHandler::AddStatNearestStopsRequest(const json::Dict& nearest_req){
+    const geo::Coordinates center{nearest_req.at("latitude").AsDouble(), nearest_req.at("longitude").AsDouble()};
+    const int count = nearest_req.at("count").AsInt();
+    stat_reqs_output_.push_back(BuildNearbyStops(nearest_req.at("id").AsInt(), db_->FindNearestStops(center, count > 0 ? count : 0)));
+}
+
+void TC_QueryHandler::AddStatStopsInRadiusRequest(const json::Dict& radius_req){
+    const geo::Coordinates center{radius_req.at("latitude").AsDouble(), radius_req.at("longitude").AsDouble()};
+    stat_reqs_output_.push_back(BuildNearbyStops(radius_req.at("id").AsInt(), db_->FindStopsInRadius(center, radius_req.at("radius").AsDouble())));
+}
+
+json::Node TC_QueryHandler::BuildNearbyStops(int request_id, const std::vector<Transportation::NearbyStop>& stops){
+    using namespace json;
+
+    Array stops_array;
+    stops_array.reserve(stops.size());
+    for (const Transportation::NearbyStop& nearby_stop : stops){
+        Builder stop_builder;
+        stop_builder.StartDict()
+                        .Key("distance").Value(nearby_stop.distance)
+                        .Key("stop_name").Value(nearby_stop.stop->name)
+                    .EndDict();
+        stops_array.push_back(Node{std::move(stop_builder.Build())});
+    }
+
+    Builder resp_builder;
+    resp_builder.StartDict()
+                    .Key("request_id").Value(request_id)
+                    .Key("stops").Value(std::move(stops_array))
+                .EndDict();
+    return Node{std::move(resp_builder.Build())};
+}
+
 void TC_QueryHandler::AddStatMapRequest(const int request_id, const std::string& rendered_map){
     using namespace json;
 
@@ -176,7 +329,12 @@ void TC_QueryHandler::ProcessStatRequests(std::ostream& out){
     json::Print(json::Document(std::move(stat_reqs_output_)), out);
 }
 
-JSON_TC_Builder::JSON_TC_Builder(Transportation::TransportCatalogue& transport_cat) : transp_ct_(transport_cat), query_handler_(transp_ct_) {}
+JSON_TC_Builder::JSON_TC_Builder(Transportation::CatalogueVersions& catalogue_versions) : catalogue_versions_(catalogue_versions) {}
+
+void JSON_TC_Builder::AcquireCatalogue(){
+    transp_ct_ = catalogue_versions_.Acquire();
+    query_handler_.SetCatalogue(transp_ct_);
+}
 
 void JSON_TC_Builder::BuildBaseRequests(const json::Array& base_requests){
     for (const json::Node& base_req : base_requests){
@@ -189,7 +347,10 @@ void JSON_TC_Builder::BuildBaseRequests(const json::Array& base_requests){
             query_handler_.AddBus(base_req_map);
         }
     }
-    query_handler_.ProcessBaseRequests();
+    Transportation::CatalogueBuilder catalogue_builder(catalogue_versions_);
+    query_handler_.ProcessBaseRequests(catalogue_builder.GetCatalogue());
+    catalogue_builder.Publish();
+    AcquireCatalogue();
 }
 
 svg::Color JSON_TC_Builder::ParseColor(const json::Node::Value& value){
@@ -231,6 +392,18 @@ void JSON_TC_Builder::BuildStatRequests(const json::Array& stat_requests, std::o
         else if (type == "Route"){
             query_handler_.AddStatRouteRequest(stat_req_map, p_router_);
         }
+        else if (type == "Matrix"){
+            query_handler_.AddStatMatrixRequest(stat_req_map, p_router_);
+        }
+        else if (type == "Isochrone"){
+            query_handler_.AddStatIsochroneRequest(stat_req_map, p_router_);
+        }
+        else if (type == "NearestStops"){
+            query_handler_.AddStatNearestStopsRequest(stat_req_map);
+        }
+        else if (type == "StopsInRadius"){
+            query_handler_.AddStatStopsInRadiusRequest(stat_req_map);
+        }
         else if (type == "Map"){
             std::ostringstream os;
             p_map_rendered_->Render(os);
@@ -265,7 +438,32 @@ void JSON_TC_Builder::BuildMap(const json::Dict& settings){
             color_palette.push_back(ParseColor(color_node.GetValue()));
         }
     }
-    p_map_rendered_ = std::make_unique<map_renderer::MapRenderer>(width, height, padding, line_width, stop_radius, bus_label_font_size, std::move(bus_label_offset), stop_label_font_size, std::move(stop_label_offset), std::move(underlayer_color), underlayer_width, std::move(color_palette), transp_ct_);
+    p_map_rendered_ = std::make_unique<map_renderer::MapRenderer>(width, height, padding, line_width, stop_radius, bus_label_font_size, std::move(bus_label_offset), stop_label_font_size, std::move(stop_label_offset), std::move(underlayer_color), underlayer_width, std::move(color_palette), *transp_ct_);
+}
+
+Transportation::RouterBackend JSON_TC_Builder::ParseRouterBackend(const std::string& name){
+    if (name == "all_pairs"){
+        return Transportation::RouterBackend::ALL_PAIRS;
+    }
+    else if (name == "all_pairs_compact"){
+        return Transportation::RouterBackend::ALL_PAIRS_COMPACT;
+    }
+    else if (name == "dijkstra"){
+        return Transportation::RouterBackend::DIJKSTRA;
+    }
+    else if (name == "a_star"){
+        return Transportation::RouterBackend::A_STAR;
+    }
+    else if (name == "bidirectional"){
+        return Transportation::RouterBackend::BIDIRECTIONAL;
+    }
+    else if (name == "contraction_hierarchy"){
+        return Transportation::RouterBackend::CONTRACTION_HIERARCHY;
+    }
+    else if (name == "raptor"){
+        return Transportation::RouterBackend::RAPTOR;
+    }
+    throw std::logic_error("'router_backend' can be \"all_pairs\", \"all_pairs_compact\", \"dijkstra\", \"a_star\", \"bidirectional\", \"contraction_hierarchy\" or \"raptor\".");
 }
 
 void JSON_TC_Builder::BuildRouter(const json::Dict& settings){
@@ -273,8 +471,31 @@ void JSON_TC_Builder::BuildRouter(const json::Dict& settings){
         .bus_velocity = settings.at("bus_velocity").AsDouble(),
         .bus_wait_time = settings.at("bus_wait_time").AsInt()
     };
+    if (settings.count("router_backend")){
+        config.backend = ParseRouterBackend(settings.at("router_backend").AsString());
+    }
+    if (settings.count("route_cache_mb")){
+        const double route_cache_mb = settings.at("route_cache_mb").AsDouble();
+        if (route_cache_mb < 0){
+            throw std::logic_error("'route_cache_mb' can't be negative.");
+        }
+        config.route_cache_size = static_cast<size_t>(route_cache_mb * 1024 * 1024);
+    }
+    if (settings.count("snapshot_file")){
+        config.snapshot_file = settings.at("snapshot_file").AsString();
+    }
+    if (settings.count("walking_speed") || settings.count("max_walk_distance")){
+        if (!settings.count("walking_speed") || !settings.count("max_walk_distance")){
+            throw std::logic_error("'walking_speed' and 'max_walk_distance' must be set together.");
+        }
+        config.walking_speed = settings.at("walking_speed").AsDouble();
+        config.max_walk_distance = settings.at("max_walk_distance").AsDouble();
+        if (config.walking_speed <= 0 || config.max_walk_distance < 0){
+            throw std::logic_error("'walking_speed' must be positive, and 'max_walk_distance' can't be negative.");
+        }
+    }
 
-    p_router_ = std::make_unique<Transportation::Router>(std::move(config), transp_ct_);
+    p_router_ = std::make_unique<Transportation::Router>(std::move(config), *transp_ct_);
 }
 
 void JSON_TC_Builder::BuildData(std::ostream& out){
@@ -288,6 +509,40 @@ void JSON_TC_Builder::BuildData(std::ostream& out){
     BuildStatRequests(p_read_json_data_->at("stat_requests").AsArray(), out);
 }
 
+const std::string& JSON_TC_Builder::GetBaseFile() const{
+    return p_read_json_data_->at("serialization_settings").AsDict().at("file").AsString();
+}
+
+void JSON_TC_Builder::MakeBase(){
+    if (!p_read_json_data_){
+        throw std::logic_error("No JSON data has been read to build data from.");
+    }
+
+    BuildBaseRequests(p_read_json_data_->at("base_requests").AsArray());
+    const serialization::BaseSettings settings{
+        .render_settings = p_read_json_data_->at("render_settings").AsDict(),
+        .routing_settings = p_read_json_data_->at("routing_settings").AsDict()
+    };
+    serialization::SaveBase(GetBaseFile(), *transp_ct_, settings);
+    if (settings.routing_settings.count("snapshot_file")){
+        BuildRouter(settings.routing_settings); // builds and saves the routes for process_requests runs to map
+    }
+}
+
+void JSON_TC_Builder::ProcessRequests(std::ostream& out){
+    if (!p_read_json_data_){
+        throw std::logic_error("No JSON data has been read to process requests with.");
+    }
+
+    Transportation::CatalogueBuilder catalogue_builder(catalogue_versions_);
+    const serialization::BaseSettings settings = serialization::LoadBase(GetBaseFile(), catalogue_builder.GetCatalogue());
+    catalogue_builder.Publish();
+    AcquireCatalogue();
+    BuildMap(settings.render_settings);
+    BuildRouter(p_read_json_data_->count("routing_settings") ? p_read_json_data_->at("routing_settings").AsDict() : settings.routing_settings);
+    BuildStatRequests(p_read_json_data_->at("stat_requests").AsArray(), out);
+}
+
 void JSON_TC_Builder::ReadData(std::istream& in){
     json::Document json_data(json::Load(in));
     p_read_json_data_ = std::make_unique<json::Dict>(json_data.GetRoot().AsDict());
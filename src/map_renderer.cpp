@@ -25,7 +25,7 @@ MapRenderer::MapRenderer(double width, double height, double padding, double lin
 
 
 void MapRenderer::DrawStops(){
-    std::vector<const Stop*> stops = transport_db_.GetUsedStops();
+    const std::vector<const Stop*>& stops = transport_db_.GetUsedStops();
 
     for (const Stop* stop : stops){
         svg_document_.Add(svg::Circle{}.SetCenter(geo_proj_(stop->coordinates)).SetFillColor("white").SetRadius(stop_radius_));
@@ -49,7 +49,7 @@ void MapRenderer::DrawRoutes(){
         }
     };
 
-    std::vector<const Bus*> buses = transport_db_.GetAllBuses();
+    const std::vector<const Bus*>& buses = transport_db_.GetAllBuses();
 
     for (const Bus* bus : buses){
         index_check();
@@ -62,12 +62,10 @@ void MapRenderer::DrawRoutes(){
             .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
             .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-        const std::vector<Stop*>& bus_stops = bus->stops;
+        const std::vector<geo::Coordinates>& stops_coordinates = transport_db_.GetStopsCoordinates();
 
-        for (const Stop* stop : bus_stops){
-            if (stop){
-                line.AddPoint(geo_proj_(stop->coordinates));
-            }
+        for (const StopId stop : bus->stops){
+            line.AddPoint(geo_proj_(stops_coordinates[stop]));
         }
 
         svg_document_.Add(std::move(line));
@@ -77,7 +75,7 @@ void MapRenderer::DrawRoutes(){
 
     for (const Bus* bus : buses){
         index_check();
-        svg::Point first_text_pos = geo_proj_(bus->stops[0]->coordinates);
+        svg::Point first_text_pos = geo_proj_(transport_db_.GetStop(bus->stops[0]).coordinates);
         svg::Point text_offset{bus_label_offset_.first, bus_label_offset_.second};
 
         const auto add_route_text = [&](svg::Point text_pos){
@@ -107,7 +105,7 @@ void MapRenderer::DrawRoutes(){
         size_t middle_stop_index = bus->stops.size() / 2;
         
         if (!bus->round_route && bus->stops.at(middle_stop_index) != bus->stops.at(0)){
-            add_route_text(geo_proj_(bus->stops.at(middle_stop_index)->coordinates));
+            add_route_text(geo_proj_(transport_db_.GetStop(bus->stops.at(middle_stop_index)).coordinates));
         }
         ++color_palette_index;
     }
@@ -0,0 +1,412 @@
+#include "headers/transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace Transportation{
+
+RaptorRouter::RaptorRouter(const RouterConfig& config, const TransportCatalogue& transp_db)
+    : meters_per_minute_(config.bus_velocity * KMH_TO_MM_COEF)
+    , wait_time_(static_cast<double>(config.bus_wait_time))
+    , walking_meters_per_minute_(config.HasWalking() ? config.walking_speed * KMH_TO_MM_COEF : 0.0)
+    , max_walk_distance_(config.max_walk_distance)
+    , stops_(transp_db.GetAllStops())
+{
+    stopname_to_index_.reserve(stops_.size());
+    stopid_to_index_.assign(transp_db.GetStopCount(), NO_POSITION);
+    for (size_t i = 0; i < stops_.size(); ++i){
+        stopname_to_index_[stops_[i]->name] = i;
+        stopid_to_index_[stops_[i]->id] = i;
+    }
+
+    footpaths_.resize(stops_.size());
+    if (walking_meters_per_minute_ > 0){
+        SpatialJoinStats join_stats;
+        for (const auto& [first, second, distance] : JoinStopsWithinDistance(stops_, max_walk_distance_, &join_stats)){
+            const size_t first_index = stopid_to_index_[first->id];
+            const size_t second_index = stopid_to_index_[second->id];
+            footpaths_[first_index].emplace_back(second_index, distance / walking_meters_per_minute_);
+            footpaths_[second_index].emplace_back(first_index, distance / walking_meters_per_minute_);
+        }
+        walking_stats_ = WalkingTransferStats{
+            .compared_pairs = join_stats.compared_pairs,
+            .walking_edges = join_stats.found_pairs * 2,
+            .seconds = join_stats.seconds
+        };
+    }
+
+    for (const Bus* bus : transp_db.GetAllBuses()){
+        AddBusPatterns(bus, transp_db);
+    }
+    IndexPatterns();
+}
+
+bool RaptorRouter::HasStop(std::string_view stop_name) const{
+    return stopname_to_index_.count(stop_name) > 0;
+}
+
+bool RaptorRouter::HasBus(std::string_view bus_name) const{
+    return bus_patterns_.count(bus_name) > 0;
+}
+
+void RaptorRouter::AddStop(const Stop* stop){
+    if (HasStop(stop->name)){
+        throw std::logic_error("[!] The stop has already been added to the router.");
+    }
+    stopname_to_index_[stop->name] = stops_.size();
+    if (stop->id >= stopid_to_index_.size()){
+        stopid_to_index_.resize(stop->id + 1, NO_POSITION);
+    }
+    stopid_to_index_[stop->id] = stops_.size();
+    stops_.push_back(stop);
+    footpaths_.emplace_back();
+    AddStopFootpaths(stops_.size() - 1);
+    IndexPatterns();
+}
+
+void RaptorRouter::AddStopFootpaths(size_t stop){
+    if (walking_meters_per_minute_ == 0){
+        return;
+    }
+    const auto start_time = std::chrono::steady_clock::now();
+    for (size_t other = 0; other < stops_.size(); ++other){
+        if (other == stop){
+            continue;
+        }
+        const double distance = geo::ComputeDistance(stops_[stop]->coordinates, stops_[other]->coordinates);
+        if (distance <= max_walk_distance_){
+            footpaths_[stop].emplace_back(other, distance / walking_meters_per_minute_);
+            footpaths_[other].emplace_back(stop, distance / walking_meters_per_minute_);
+            walking_stats_.walking_edges += 2;
+        }
+        ++walking_stats_.compared_pairs;
+    }
+    walking_stats_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void RaptorRouter::AddBus(const Bus* bus, const TransportCatalogue& transp_db){
+    if (HasBus(bus->name)){
+        throw std::logic_error("[!] The bus has already been added to the router.");
+    }
+    AddBusPatterns(bus, transp_db);
+    IndexPatterns();
+}
+
+void RaptorRouter::RemoveBus(std::string_view bus_name){
+    const auto it = bus_patterns_.find(bus_name);
+    if (it == bus_patterns_.end()){
+        throw std::logic_error("[!] The bus is not known to the router.");
+    }
+    for (const size_t pattern : it->second){ // stops of removed patterns stay in place, they are just no longer indexed
+        patterns_[pattern].is_removed = true;
+    }
+    bus_patterns_.erase(it);
+    IndexPatterns();
+}
+
+void RaptorRouter::AddBusPatterns(const Bus* bus, const TransportCatalogue& transp_db){
+    std::vector<size_t>& bus_patterns = bus_patterns_[bus->name];
+    if (bus->stops.empty()){
+        return;
+    }
+    // since stops in the bus info are stored as they are on the road, a non-round route is split into two directions
+    const size_t stops_count = bus->round_route ? bus->stops.size() : bus->stops.size() / 2 + 1;
+    std::vector<StopId> stops(bus->stops.begin(), bus->stops.begin() + stops_count);
+    AddPattern(bus, stops, transp_db, bus_patterns);
+    if (!bus->round_route){
+        std::reverse(stops.begin(), stops.end());
+        AddPattern(bus, stops, transp_db, bus_patterns);
+    }
+}
+
+void RaptorRouter::IndexPatterns(){
+    stop_patterns_offsets_.assign(stops_.size() + 1, 0);
+    for (const Pattern& pattern : patterns_){
+        if (pattern.is_removed){
+            continue;
+        }
+        for (size_t position = 0; position < pattern.stops_count; ++position){
+            ++stop_patterns_offsets_[pattern_stops_[pattern.offset + position] + 1];
+        }
+    }
+    for (size_t stop = 0; stop < stops_.size(); ++stop){
+        stop_patterns_offsets_[stop + 1] += stop_patterns_offsets_[stop];
+    }
+    stop_patterns_.resize(stop_patterns_offsets_.back());
+    std::vector<size_t> fill_positions(stop_patterns_offsets_.begin(), stop_patterns_offsets_.end() - 1);
+    for (size_t pattern = 0; pattern < patterns_.size(); ++pattern){
+        if (patterns_[pattern].is_removed){
+            continue;
+        }
+        for (size_t position = 0; position < patterns_[pattern].stops_count; ++position){
+            const size_t stop = pattern_stops_[patterns_[pattern].offset + position];
+            stop_patterns_[fill_positions[stop]++] = {pattern, position};
+        }
+    }
+
+    best_arrivals_.resize(stops_.size());
+    is_marked_.assign(stops_.size(), false);
+    first_positions_.assign(patterns_.size(), NO_POSITION);
+}
+
+void RaptorRouter::AddPattern(const Bus* bus, const std::vector<StopId>& stops, const TransportCatalogue& transp_db,
+                              std::vector<size_t>& bus_patterns){
+    if (stops.size() < 2){
+        return;
+    }
+    bus_patterns.push_back(patterns_.size());
+    patterns_.push_back(Pattern{bus, pattern_stops_.size(), stops.size()});
+    for (size_t i = 0; i < stops.size(); ++i){
+        pattern_stops_.push_back(stopid_to_index_.at(stops[i]));
+        pattern_distances_.push_back(i == 0 ? 0.0 : pattern_distances_.back() + transp_db.GetStopDistance(stops[i - 1], stops[i]));
+    }
+}
+
+double RaptorRouter::GetRideTime(const Pattern& pattern, size_t board_position, size_t alight_position) const{
+    return (pattern_distances_[pattern.offset + alight_position] - pattern_distances_[pattern.offset + board_position]) / meters_per_minute_;
+}
+
+double RaptorRouter::GetArrivalBound(std::optional<size_t> target) const{
+    return target ? std::min(best_arrivals_[*target], arrival_limit_) : arrival_limit_;
+}
+
+void RaptorRouter::ScanPattern(size_t pattern_id, size_t first_position, size_t round, std::optional<size_t> target) const{
+    const Pattern& pattern = patterns_[pattern_id];
+    const std::vector<Label>& prev_labels = round_labels_[round - 1];
+    std::vector<Label>& labels = round_labels_[round];
+    std::optional<size_t> board_position;
+    size_t board_leg = NO_LEG;
+    double departure = 0;
+
+    for (size_t position = first_position; position < pattern.stops_count; ++position){
+        const size_t stop = pattern_stops_[pattern.offset + position];
+        std::optional<double> arrival;
+        if (board_position){
+            arrival = departure + GetRideTime(pattern, *board_position, position);
+            if (*arrival < best_arrivals_[stop] && *arrival < GetArrivalBound(target)){
+                best_arrivals_[stop] = *arrival;
+                legs_.push_back(Leg{pattern_id, *board_position, position, board_leg});
+                labels[stop] = Label{*arrival, legs_.size() - 1};
+                if (!is_marked_[stop]){
+                    is_marked_[stop] = true;
+                    marked_stops_.push_back(stop);
+                }
+            }
+        }
+
+        // a later bus may be caught here if the stop has been reached earlier than the current one passes it
+        if (prev_labels[stop].arrival == std::numeric_limits<double>::infinity()){
+            continue;
+        }
+        const double stop_departure = prev_labels[stop].arrival + wait_time_;
+        if (stop_departure < GetArrivalBound(target) && (!arrival || stop_departure < *arrival)){
+            board_position = position;
+            board_leg = prev_labels[stop].leg;
+            departure = stop_departure;
+        }
+    }
+}
+
+void RaptorRouter::RunRounds(size_t source, std::optional<size_t> target, double max_arrival) const{
+    const Label no_label{std::numeric_limits<double>::infinity(), NO_LEG};
+    const auto start_round = [&](size_t round){
+        if (round_labels_.size() == round){
+            round_labels_.emplace_back();
+        }
+        round_labels_[round].assign(stops_.size(), no_label);
+        round_count_ = round + 1;
+    };
+
+    std::fill(best_arrivals_.begin(), best_arrivals_.end(), std::numeric_limits<double>::infinity());
+    legs_.clear();
+    arrival_limit_ = std::nextafter(max_arrival, std::numeric_limits<double>::infinity()); // arrivals at the limit are kept
+    start_round(0);
+    round_labels_[0][source] = Label{0, NO_LEG};
+    best_arrivals_[source] = 0;
+    marked_stops_.assign(1, source);
+    is_marked_[source] = true;
+    RelaxFootpaths(0, target);
+
+    for (size_t round = 1; !marked_stops_.empty(); ++round){
+        for (const size_t stop : marked_stops_){ // patterns are scanned from the earliest stop improved in the previous round
+            is_marked_[stop] = false;
+            for (size_t i = stop_patterns_offsets_[stop]; i < stop_patterns_offsets_[stop + 1]; ++i){
+                const auto [pattern, position] = stop_patterns_[i];
+                if (first_positions_[pattern] == NO_POSITION){
+                    queued_patterns_.push_back(pattern);
+                    first_positions_[pattern] = position;
+                }
+                else{
+                    first_positions_[pattern] = std::min(first_positions_[pattern], position);
+                }
+            }
+        }
+        marked_stops_.clear();
+
+        start_round(round);
+        for (const size_t pattern : queued_patterns_){
+            ScanPattern(pattern, first_positions_[pattern], round, target);
+            first_positions_[pattern] = NO_POSITION;
+        }
+        queued_patterns_.clear();
+        RelaxFootpaths(round, target);
+    }
+}
+
+void RaptorRouter::RelaxFootpaths(size_t round, std::optional<size_t> target) const{
+    if (walking_meters_per_minute_ == 0){
+        return;
+    }
+    // walks may be chained, so they are relaxed in the order of arrivals, as Dijkstra's algorithm does
+    std::vector<Label>& labels = round_labels_[round];
+    const auto is_later = [](const std::pair<double, size_t>& lhs, const std::pair<double, size_t>& rhs){
+        return lhs.first > rhs.first;
+    };
+    walk_queue_.clear();
+    for (const size_t stop : marked_stops_){
+        walk_queue_.emplace_back(labels[stop].arrival, stop);
+    }
+    std::make_heap(walk_queue_.begin(), walk_queue_.end(), is_later);
+    while (!walk_queue_.empty()){
+        std::pop_heap(walk_queue_.begin(), walk_queue_.end(), is_later);
+        const auto [arrival, stop] = walk_queue_.back();
+        walk_queue_.pop_back();
+        if (arrival > labels[stop].arrival){ // improved since queued
+            continue;
+        }
+        for (const auto& [other, walk_time] : footpaths_[stop]){
+            const double walk_arrival = arrival + walk_time;
+            if (walk_arrival >= best_arrivals_[other] || walk_arrival >= GetArrivalBound(target)){
+                continue;
+            }
+            best_arrivals_[other] = walk_arrival;
+            legs_.push_back(Leg{NO_PATTERN, stop, other, labels[stop].leg});
+            labels[other] = Label{walk_arrival, legs_.size() - 1};
+            if (!is_marked_[other]){
+                is_marked_[other] = true;
+                marked_stops_.push_back(other);
+            }
+            walk_queue_.emplace_back(walk_arrival, other);
+            std::push_heap(walk_queue_.begin(), walk_queue_.end(), is_later);
+        }
+    }
+}
+
+RouteResponse RaptorRouter::MakeResponse(const Label& label) const{
+    std::vector<size_t> journey;
+    for (size_t leg = label.leg; leg != NO_LEG; leg = legs_[leg].prev_leg){
+        journey.push_back(leg);
+    }
+    std::reverse(journey.begin(), journey.end());
+
+    RouteResponse resp;
+    resp.success = true;
+    resp.total_time = label.arrival;
+    resp.route_items.reserve(journey.size() * 2);
+
+    for (const size_t leg_id : journey){
+        const Leg& leg = legs_[leg_id];
+        if (leg.pattern == NO_PATTERN){
+            const auto footpath = std::find_if(footpaths_[leg.board_position].begin(), footpaths_[leg.board_position].end(),
+                                               [&](const auto& path){ return path.first == leg.alight_position; });
+            resp.route_items.push_back(RouteItem{
+                .type = RouteItemType::WALK,
+                .name = stops_[leg.alight_position]->name,
+                .span_count = 0,
+                .spent_time = footpath->second
+            });
+            continue;
+        }
+        const Pattern& pattern = patterns_[leg.pattern];
+        resp.route_items.push_back(RouteItem{
+            .type = RouteItemType::WAIT,
+            .name = stops_[pattern_stops_[pattern.offset + leg.board_position]]->name,
+            .span_count = 0,
+            .spent_time = wait_time_
+        });
+        resp.route_items.push_back(RouteItem{
+            .type = RouteItemType::BUS,
+            .name = pattern.bus->name,
+            .span_count = static_cast<int>(leg.alight_position - leg.board_position),
+            .spent_time = GetRideTime(pattern, leg.board_position, leg.alight_position)
+        });
+    }
+    return resp;
+}
+
+RouteResponse RaptorRouter::FindRoute(std::string_view stop_from, std::string_view stop_to) const{
+    const auto stop_from_it = stopname_to_index_.find(stop_from);
+    const auto stop_to_it = stopname_to_index_.find(stop_to);
+    if (stop_from_it == stopname_to_index_.end() || stop_to_it == stopname_to_index_.end()){
+        return RouteResponse{.error = "[!] One of the provided stops does not exist."};
+    }
+
+    const size_t target = stop_to_it->second;
+    RunRounds(stop_from_it->second, target);
+
+    for (size_t round = round_count_; round-- > 0;){ // the last arrival is the fastest one
+        if (round_labels_[round][target].arrival != std::numeric_limits<double>::infinity()){
+            return MakeResponse(round_labels_[round][target]);
+        }
+    }
+    return RouteResponse{.error = "[!] Failed to build route."};
+}
+
+std::vector<RouteResponse> RaptorRouter::FindParetoRoutes(std::string_view stop_from, std::string_view stop_to) const{
+    std::vector<RouteResponse> routes;
+    const auto stop_from_it = stopname_to_index_.find(stop_from);
+    const auto stop_to_it = stopname_to_index_.find(stop_to);
+    if (stop_from_it == stopname_to_index_.end() || stop_to_it == stopname_to_index_.end()){
+        return routes;
+    }
+
+    const size_t target = stop_to_it->second;
+    RunRounds(stop_from_it->second, target);
+
+    // every arrival at the target is faster than the ones of the previous rounds, so none of them dominates another
+    for (size_t round = 0; round < round_count_; ++round){
+        if (round_labels_[round][target].arrival != std::numeric_limits<double>::infinity()){
+            routes.push_back(MakeResponse(round_labels_[round][target]));
+        }
+    }
+    return routes;
+}
+
+std::vector<std::optional<double>> RaptorRouter::ComputeTimes(std::string_view stop_from, const std::vector<std::string_view>& stops_to) const{
+    std::vector<std::optional<double>> times(stops_to.size());
+    const auto stop_from_it = stopname_to_index_.find(stop_from);
+    if (stop_from_it == stopname_to_index_.end()){
+        return times;
+    }
+
+    RunRounds(stop_from_it->second, std::nullopt);
+    for (size_t i = 0; i < stops_to.size(); ++i){
+        const auto stop_to_it = stopname_to_index_.find(stops_to[i]);
+        if (stop_to_it != stopname_to_index_.end() && best_arrivals_[stop_to_it->second] != std::numeric_limits<double>::infinity()){
+            times[i] = best_arrivals_[stop_to_it->second];
+        }
+    }
+    return times;
+}
+
+std::optional<std::vector<std::pair<std::string_view, double>>> RaptorRouter::FindReachableStops(std::string_view stop_from, double max_time) const{
+    const auto stop_from_it = stopname_to_index_.find(stop_from);
+    if (stop_from_it == stopname_to_index_.end()){
+        return std::nullopt;
+    }
+
+    RunRounds(stop_from_it->second, std::nullopt, max_time);
+    std::vector<std::pair<std::string_view, double>> reachable;
+    for (size_t stop = 0; stop < stops_.size(); ++stop){
+        if (best_arrivals_[stop] <= max_time){
+            reachable.emplace_back(stops_[stop]->name, best_arrivals_[stop]);
+        }
+    }
+    return reachable;
+}
+
+} // namespace Transportation
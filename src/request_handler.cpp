@@ -1,10 +1,16 @@
 #include "headers/request_handler.h"
 
-RequestHandler::RequestHandler(Transportation::TransportCatalogue& db) : data_builder_(db) {}
+RequestHandler::RequestHandler(Transportation::CatalogueVersions& db) : data_builder_(db) {}
 
 void RequestHandler::ReadInput(std::istream& in){
     data_builder_.ReadData(in);
 }
 void RequestHandler::ProcessInput(std::ostream& out){
     data_builder_.BuildData(out);
+}
+void RequestHandler::MakeBase(){
+    data_builder_.MakeBase();
+}
+void RequestHandler::ProcessRequests(std::ostream& out){
+    data_builder_.ProcessRequests(out);
 }
\ No newline at end of file
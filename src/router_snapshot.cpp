@@ -0,0 +1,406 @@
+#include "headers/transport_router.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Transportation{
+
+// File layout: the header, then the sections it points to, each aligned to 8 bytes. Numbers are in the byte
+// order of the machine the file has been written on, which the header lets the reader check.
+struct RouterSnapshot::Header{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint64_t fingerprint;
+    uint64_t stop_count; // vertices are 2 per stop
+    uint64_t edge_count;
+    uint64_t names_size;
+    uint64_t stop_names_offset; // NameRef[stop_count]
+    uint64_t sorted_stops_offset; // uint32_t[stop_count]
+    uint64_t edges_offset; // EdgeRecord[edge_count]
+    uint64_t prev_edges_offset; // uint32_t[vertex_count * vertex_count], the last edges of all-pairs routes
+    uint64_t weights_offset; // double[vertex_count * vertex_count], weights of all-pairs routes, or 0 to sum them up by edges
+    uint64_t names_offset; // char[names_size]
+    uint64_t file_size;
+};
+
+struct RouterSnapshot::NameRef{
+    uint32_t offset; // in the names section
+    uint32_t length;
+};
+
+// An edge of the graph along with its route item.
+struct RouterSnapshot::EdgeRecord{
+    double spent_time;
+    NameRef name;
+    uint32_t from;
+    int32_t span_count;
+    uint32_t type;
+    uint32_t padding;
+};
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'T', 'R', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+uint64_t AlignOffset(uint64_t offset){
+    return (offset + 7) / 8 * 8;
+}
+
+// FNV-1a
+class Hasher{
+public:
+    void Add(const void* data, size_t size){
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i){
+            hash_ = (hash_ ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+    template <typename Number>
+    void AddNumber(Number number){
+        Add(&number, sizeof(number));
+    }
+    void AddString(std::string_view str){
+        AddNumber(str.size());
+        Add(str.data(), str.size());
+    }
+    uint64_t GetHash() const{
+        return hash_;
+    }
+
+private:
+    uint64_t hash_ = 14695981039346656037ULL;
+};
+
+class SnapshotWriter{
+public:
+    explicit SnapshotWriter(const std::string& path) : out_(path, std::ios::binary | std::ios::trunc) {
+        if (!out_){
+            throw std::runtime_error("[!] Can't write the snapshot file " + path);
+        }
+    }
+
+    // Writes an array at the next aligned offset and returns the offset.
+    template <typename Item>
+    uint64_t WriteSection(const Item* items, size_t count){
+        static constexpr char ZEROS[8] = {};
+        const uint64_t offset = AlignOffset(position_);
+        out_.write(ZEROS, offset - position_);
+        out_.write(reinterpret_cast<const char*>(items), count * sizeof(Item));
+        position_ = offset + count * sizeof(Item);
+        return offset;
+    }
+
+    void WriteHeader(const void* header, size_t size){
+        out_.seekp(0);
+        out_.write(static_cast<const char*>(header), size);
+    }
+
+    uint64_t GetPosition() const{
+        return position_;
+    }
+
+    void Close(){
+        out_.close();
+        if (!out_){
+            throw std::runtime_error("[!] Failed to write the snapshot file.");
+        }
+    }
+
+private:
+    std::ofstream out_;
+    uint64_t position_ = 0;
+};
+
+} // namespace
+
+uint64_t RouterSnapshot::ComputeFingerprint(const RouterConfig& config, const TransportCatalogue& transp_db){
+    Hasher hasher;
+    hasher.AddNumber(config.bus_velocity);
+    hasher.AddNumber(config.bus_wait_time);
+    hasher.AddNumber(static_cast<uint32_t>(config.backend)); // all-pairs backends may break ties between routes differently
+    if (config.HasWalking()){ // fingerprints of snapshots without walks stay the same
+        hasher.AddNumber(config.walking_speed);
+        hasher.AddNumber(config.max_walk_distance);
+    }
+
+    const std::vector<const Stop*>& stops = transp_db.GetAllStops();
+    hasher.AddNumber(stops.size());
+    for (const Stop* stop : stops){
+        hasher.AddString(stop->name);
+        if (config.HasWalking()){ // walks depend on where the stops are
+            hasher.AddNumber(stop->coordinates.lat);
+            hasher.AddNumber(stop->coordinates.lng);
+        }
+    }
+    const std::vector<const Bus*>& buses = transp_db.GetAllBuses();
+    hasher.AddNumber(buses.size());
+    for (const Bus* bus : buses){
+        hasher.AddString(bus->name);
+        hasher.AddNumber(bus->round_route);
+        hasher.AddNumber(bus->stops.size());
+        for (size_t i = 0; i < bus->stops.size(); ++i){
+            hasher.AddString(transp_db.GetStop(bus->stops[i]).name);
+            if (i > 0){
+                hasher.AddNumber(transp_db.GetStopDistance(bus->stops[i - 1], bus->stops[i]));
+                hasher.AddNumber(transp_db.GetStopDistance(bus->stops[i], bus->stops[i - 1]));
+            }
+        }
+    }
+    return hasher.GetHash();
+}
+
+void RouterSnapshot::Write(const std::string& path, uint64_t fingerprint, const std::vector<std::string_view>& stop_names,
+                           const std::vector<RouteItem>& edge_items, const graph::CsrGraph<double>& graph,
+                           const std::vector<uint32_t>& prev_edges, const std::vector<double>& weights){
+    std::string names; // every stop and bus name once
+    std::unordered_map<std::string_view, NameRef> name_refs;
+    const auto add_name = [&](std::string_view name){
+        const auto [it, inserted] = name_refs.emplace(name, NameRef{static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size())});
+        if (inserted){
+            names += name;
+        }
+        return it->second;
+    };
+
+    std::vector<NameRef> stop_name_refs;
+    stop_name_refs.reserve(stop_names.size());
+    for (const std::string_view name : stop_names){
+        stop_name_refs.push_back(add_name(name));
+    }
+    std::vector<uint32_t> sorted_stops(stop_names.size());
+    std::iota(sorted_stops.begin(), sorted_stops.end(), 0);
+    std::sort(sorted_stops.begin(), sorted_stops.end(), [&](uint32_t lhs, uint32_t rhs){ return stop_names[lhs] < stop_names[rhs]; });
+
+    std::vector<EdgeRecord> edges;
+    edges.reserve(edge_items.size());
+    for (graph::EdgeId eid = 0; eid < edge_items.size(); ++eid){
+        const RouteItem& item = edge_items[eid];
+        edges.push_back(EdgeRecord{item.spent_time, add_name(item.name), static_cast<uint32_t>(graph.GetEdge(eid).from),
+                                   item.span_count, static_cast<uint32_t>(item.type), 0});
+    }
+    if (names.size() > std::numeric_limits<uint32_t>::max()){
+        throw std::length_error("[!] Too long names for a snapshot.");
+    }
+
+    // written aside and renamed, so that other processes either map the old file or the complete new one
+    const std::string temp_path = path + ".tmp";
+    Header header{};
+    std::copy(std::begin(SNAPSHOT_MAGIC), std::end(SNAPSHOT_MAGIC), header.magic);
+    header.version = VERSION;
+    header.byte_order_mark = BYTE_ORDER_MARK;
+    header.fingerprint = fingerprint;
+    header.stop_count = stop_names.size();
+    header.edge_count = edges.size();
+    header.names_size = names.size();
+    {
+        SnapshotWriter writer(temp_path);
+        writer.WriteSection(&header, 1);
+        header.stop_names_offset = writer.WriteSection(stop_name_refs.data(), stop_name_refs.size());
+        header.sorted_stops_offset = writer.WriteSection(sorted_stops.data(), sorted_stops.size());
+        header.edges_offset = writer.WriteSection(edges.data(), edges.size());
+        header.prev_edges_offset = writer.WriteSection(prev_edges.data(), prev_edges.size());
+        header.weights_offset = weights.empty() ? 0 : writer.WriteSection(weights.data(), weights.size());
+        header.names_offset = writer.WriteSection(names.data(), names.size());
+        header.file_size = writer.GetPosition();
+        writer.WriteHeader(&header, sizeof(header));
+        writer.Close();
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0){
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("[!] Can't write the snapshot file " + path);
+    }
+}
+
+std::unique_ptr<RouterSnapshot> RouterSnapshot::Open(const std::string& path, uint64_t fingerprint){
+    std::unique_ptr<RouterSnapshot> snapshot(new RouterSnapshot());
+#if defined(_WIN32)
+    std::ifstream in(path, std::ios::binary);
+    if (!in){
+        return nullptr;
+    }
+    snapshot->buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    snapshot->size_ = snapshot->buffer_.size();
+    snapshot->data_ = snapshot->buffer_.data();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        return nullptr;
+    }
+    struct stat file_stat{};
+    if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(Header))){
+        ::close(fd);
+        return nullptr;
+    }
+    void* mapping = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED){
+        return nullptr;
+    }
+    snapshot->data_ = static_cast<const char*>(mapping);
+    snapshot->size_ = file_stat.st_size;
+#endif
+
+    if (snapshot->size_ < sizeof(Header)){
+        return nullptr;
+    }
+    const Header& header = *reinterpret_cast<const Header*>(snapshot->data_);
+    const uint64_t vertex_count = header.stop_count * 2;
+    const auto fits = [&](uint64_t offset, uint64_t count, size_t item_size){
+        return offset % 8 == 0 && offset <= header.file_size && count <= (header.file_size - offset) / item_size;
+    };
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.version != VERSION
+        || header.byte_order_mark != BYTE_ORDER_MARK || header.fingerprint != fingerprint || header.file_size != snapshot->size_
+        || !fits(header.stop_names_offset, header.stop_count, sizeof(NameRef))
+        || !fits(header.sorted_stops_offset, header.stop_count, sizeof(uint32_t))
+        || !fits(header.edges_offset, header.edge_count, sizeof(EdgeRecord))
+        || !fits(header.prev_edges_offset, vertex_count * vertex_count, sizeof(uint32_t))
+        || (header.weights_offset != 0 && !fits(header.weights_offset, vertex_count * vertex_count, sizeof(double)))
+        || !fits(header.names_offset, header.names_size, 1)){
+        return nullptr;
+    }
+
+    snapshot->header_ = &header;
+    snapshot->stop_names_ = reinterpret_cast<const NameRef*>(snapshot->data_ + header.stop_names_offset);
+    snapshot->sorted_stops_ = reinterpret_cast<const uint32_t*>(snapshot->data_ + header.sorted_stops_offset);
+    snapshot->edges_ = reinterpret_cast<const EdgeRecord*>(snapshot->data_ + header.edges_offset);
+    snapshot->prev_edges_ = reinterpret_cast<const uint32_t*>(snapshot->data_ + header.prev_edges_offset);
+    if (header.weights_offset != 0){
+        snapshot->weights_ = reinterpret_cast<const double*>(snapshot->data_ + header.weights_offset);
+    }
+    snapshot->names_ = snapshot->data_ + header.names_offset;
+    return snapshot;
+}
+
+RouterSnapshot::~RouterSnapshot(){
+#if !defined(_WIN32)
+    if (data_){
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+std::string_view RouterSnapshot::GetName(const NameRef& name) const{
+    return {names_ + name.offset, name.length};
+}
+
+std::optional<uint32_t> RouterSnapshot::FindStop(std::string_view stop_name) const{
+    const uint32_t* sorted_end = sorted_stops_ + header_->stop_count;
+    const uint32_t* it = std::lower_bound(sorted_stops_, sorted_end, stop_name, [this](uint32_t stop, std::string_view name){
+        return GetName(stop_names_[stop]) < name;
+    });
+    if (it == sorted_end || GetName(stop_names_[*it]) != stop_name){
+        return std::nullopt;
+    }
+    return *it;
+}
+
+std::optional<std::vector<uint32_t>> RouterSnapshot::CollectRouteEdges(uint64_t from, uint64_t to) const{
+    const uint64_t vertex_count = header_->stop_count * 2;
+    if (from != to && prev_edges_[from * vertex_count + to] == NO_EDGE){
+        return std::nullopt;
+    }
+    std::vector<uint32_t> edges;
+    for (uint32_t eid = prev_edges_[from * vertex_count + to]; eid != NO_EDGE; eid = prev_edges_[from * vertex_count + edges_[eid].from]){
+        edges.push_back(eid);
+    }
+    return edges;
+}
+
+std::optional<double> RouterSnapshot::ComputeTime(uint64_t from, uint64_t to) const{
+    const uint64_t vertex_count = header_->stop_count * 2;
+    if (weights_){
+        if (from != to && prev_edges_[from * vertex_count + to] == NO_EDGE){
+            return std::nullopt;
+        }
+        return weights_[from * vertex_count + to];
+    }
+    const std::optional<std::vector<uint32_t>> edges = CollectRouteEdges(from, to);
+    if (!edges){
+        return std::nullopt;
+    }
+    double time = 0; // summed up from the first edge, as graph::Router does
+    for (auto it = edges->rbegin(); it != edges->rend(); ++it){
+        time += edges_[*it].spent_time;
+    }
+    return time;
+}
+
+RouteResponse RouterSnapshot::FindRoute(std::string_view stop_from, std::string_view stop_to) const{
+    if (header_->edge_count == 0){
+        return RouteResponse{.error = "[!] The graph contains no connecting edges."};
+    }
+    const std::optional<uint32_t> from = FindStop(stop_from);
+    const std::optional<uint32_t> to = FindStop(stop_to);
+    if (!from || !to){
+        return RouteResponse{.error = "[!] One of the provided stops does not exist."};
+    }
+
+    const std::optional<std::vector<uint32_t>> edges = CollectRouteEdges(*from * 2ULL, *to * 2ULL);
+    if (!edges){
+        return RouteResponse{.error = "[!] Failed to build route."};
+    }
+    RouteResponse resp;
+    resp.success = true;
+    resp.route_items.reserve(edges->size());
+    for (auto it = edges->rbegin(); it != edges->rend(); ++it){
+        const EdgeRecord& edge = edges_[*it];
+        resp.total_time += edge.spent_time;
+        resp.route_items.push_back(RouteItem{
+            .type = static_cast<RouteItemType>(edge.type),
+            .name = GetName(edge.name),
+            .span_count = edge.span_count,
+            .spent_time = edge.spent_time
+        });
+    }
+    if (weights_){ // as the router has computed it, rather than summed up in another order
+        const uint64_t vertex_count = header_->stop_count * 2;
+        resp.total_time = weights_[*from * 2ULL * vertex_count + *to * 2ULL];
+    }
+    return resp;
+}
+
+std::vector<std::optional<double>> RouterSnapshot::ComputeTimes(std::string_view stop_from, const std::vector<std::string_view>& stops_to) const{
+    std::vector<std::optional<double>> times(stops_to.size());
+    const std::optional<uint32_t> from = FindStop(stop_from);
+    if (!from || header_->edge_count == 0){
+        return times;
+    }
+    for (size_t i = 0; i < stops_to.size(); ++i){
+        if (const std::optional<uint32_t> to = FindStop(stops_to[i])){
+            times[i] = ComputeTime(*from * 2ULL, *to * 2ULL);
+        }
+    }
+    return times;
+}
+
+std::optional<std::vector<std::pair<std::string_view, double>>> RouterSnapshot::FindReachableStops(std::string_view stop_from, double max_time) const{
+    const std::optional<uint32_t> from = FindStop(stop_from);
+    if (!from){
+        return std::nullopt;
+    }
+    std::vector<std::pair<std::string_view, double>> reachable;
+    for (uint64_t stop = 0; stop < header_->stop_count; ++stop){
+        const std::optional<double> time = ComputeTime(*from * 2ULL, stop * 2);
+        if (time && !(max_time < *time)){
+            reachable.emplace_back(GetName(stop_names_[stop]), *time);
+        }
+    }
+    return reachable;
+}
+
+} // namespace Transportation
@@ -0,0 +1,263 @@
+#include "headers/serialization.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace serialization {
+
+namespace {
+
+// File layout: the magic and the version, then stops (names and coordinates), road distances by stop indices,
+// buses (names, round flags and stop indices as given on input) and the settings as tagged JSON nodes.
+// Numbers are in the byte order of the machine the file has been written on.
+constexpr char BASE_MAGIC[8] = {'T', 'C', 'B', 'A', 'S', 'E', '\0', '\0'};
+constexpr uint32_t BASE_VERSION = 1;
+
+enum class NodeTag : uint8_t {
+    NULL_VALUE, ARRAY, DICT, BOOL, INT, DOUBLE, STRING
+};
+
+class BaseWriter {
+public:
+    explicit BaseWriter(const std::string& path)
+        : out_(path, std::ios::binary | std::ios::trunc) {
+        if (!out_) {
+            throw std::runtime_error("Can't write the database file " + path);
+        }
+    }
+
+    template <typename Number>
+    void WriteNumber(Number number) {
+        out_.write(reinterpret_cast<const char*>(&number), sizeof(number));
+    }
+
+    void WriteString(const std::string& str) {
+        WriteNumber(static_cast<uint32_t>(str.size()));
+        out_.write(str.data(), str.size());
+    }
+
+    void WriteNode(const json::Node& node) {
+        if (node.IsArray()) {
+            WriteNumber(NodeTag::ARRAY);
+            WriteNumber(static_cast<uint32_t>(node.AsArray().size()));
+            for (const json::Node& item : node.AsArray()) {
+                WriteNode(item);
+            }
+        }
+        else if (node.IsDict()) {
+            WriteDict(node.AsDict());
+        }
+        else if (node.IsBool()) {
+            WriteNumber(NodeTag::BOOL);
+            WriteNumber(static_cast<uint8_t>(node.AsBool()));
+        }
+        else if (node.IsInt()) {
+            WriteNumber(NodeTag::INT);
+            WriteNumber(static_cast<int32_t>(node.AsInt()));
+        }
+        else if (node.IsPureDouble()) {
+            WriteNumber(NodeTag::DOUBLE);
+            WriteNumber(node.AsDouble());
+        }
+        else if (node.IsString()) {
+            WriteNumber(NodeTag::STRING);
+            WriteString(node.AsString());
+        }
+        else {
+            WriteNumber(NodeTag::NULL_VALUE);
+        }
+    }
+
+    void WriteDict(const json::Dict& dict) {
+        WriteNumber(NodeTag::DICT);
+        WriteNumber(static_cast<uint32_t>(dict.size()));
+        for (const auto& [key, value] : dict) {
+            WriteString(key);
+            WriteNode(value);
+        }
+    }
+
+    void Write(const char* data, size_t size) {
+        out_.write(data, size);
+    }
+
+    void Close() {
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("Failed to write the database file");
+        }
+    }
+
+private:
+    std::ofstream out_;
+};
+
+class BaseReader {
+public:
+    explicit BaseReader(const std::string& path)
+        : in_(path, std::ios::binary) {
+        if (!in_) {
+            throw std::runtime_error("Can't read the database file " + path);
+        }
+    }
+
+    template <typename Number>
+    Number ReadNumber() {
+        Number number{};
+        Read(reinterpret_cast<char*>(&number), sizeof(number));
+        return number;
+    }
+
+    std::string ReadString() {
+        std::string str(ReadNumber<uint32_t>(), '\0');
+        Read(str.data(), str.size());
+        return str;
+    }
+
+    json::Node ReadNode() {
+        switch (ReadNumber<NodeTag>()) {
+            case NodeTag::NULL_VALUE:
+                return json::Node(nullptr);
+            case NodeTag::ARRAY: {
+                json::Array array(ReadNumber<uint32_t>());
+                for (json::Node& item : array) {
+                    item = ReadNode();
+                }
+                return json::Node(std::move(array));
+            }
+            case NodeTag::DICT: {
+                json::Dict dict;
+                for (uint32_t i = ReadNumber<uint32_t>(); i > 0; --i) {
+                    std::string key = ReadString();
+                    dict.emplace(std::move(key), ReadNode());
+                }
+                return json::Node(std::move(dict));
+            }
+            case NodeTag::BOOL:
+                return json::Node(ReadNumber<uint8_t>() != 0);
+            case NodeTag::INT:
+                return json::Node(static_cast<int>(ReadNumber<int32_t>()));
+            case NodeTag::DOUBLE:
+                return json::Node(ReadNumber<double>());
+            case NodeTag::STRING:
+                return json::Node(ReadString());
+        }
+        throw std::runtime_error("Malformed database file");
+    }
+
+    json::Dict ReadDict() {
+        json::Node node = ReadNode();
+        if (!node.IsDict()) {
+            throw std::runtime_error("Malformed database file");
+        }
+        return node.AsDict();
+    }
+
+    void Read(char* data, size_t size) {
+        if (!in_.read(data, size)) {
+            throw std::runtime_error("Malformed database file");
+        }
+    }
+
+private:
+    std::ifstream in_;
+};
+
+}  // namespace
+
+void SaveBase(const std::string& path, const Transportation::TransportCatalogue& transp_db, const BaseSettings& settings) {
+    BaseWriter writer(path);
+    writer.Write(BASE_MAGIC, sizeof(BASE_MAGIC));
+    writer.WriteNumber(BASE_VERSION);
+
+    const std::vector<const Stop*>& stops = transp_db.GetAllStops();
+    std::vector<uint32_t> stop_indices(stops.size()); // positions in the file by StopId
+    writer.WriteNumber(static_cast<uint32_t>(stops.size()));
+    for (uint32_t i = 0; i < stops.size(); ++i) {
+        const Stop* stop = stops[i];
+        stop_indices[stop->id] = i;
+        writer.WriteString(stop->name);
+        writer.WriteNumber(stop->coordinates.lat);
+        writer.WriteNumber(stop->coordinates.lng);
+    }
+
+    std::vector<Transportation::StopDistance> distances = transp_db.GetAllStopDistances();
+    std::sort(distances.begin(), distances.end(), [&](const Transportation::StopDistance& lhs, const Transportation::StopDistance& rhs) {
+        return std::tie(stop_indices[lhs.from->id], stop_indices[lhs.to->id]) < std::tie(stop_indices[rhs.from->id], stop_indices[rhs.to->id]);
+    }); // for the same database to give the same file
+    writer.WriteNumber(static_cast<uint32_t>(distances.size()));
+    for (const Transportation::StopDistance& distance : distances) {
+        writer.WriteNumber(stop_indices[distance.from->id]);
+        writer.WriteNumber(stop_indices[distance.to->id]);
+        writer.WriteNumber(static_cast<int32_t>(distance.distance));
+    }
+
+    const std::vector<const Bus*>& buses = transp_db.GetAllBuses();
+    writer.WriteNumber(static_cast<uint32_t>(buses.size()));
+    for (const Bus* bus : buses) {
+        // the catalogue keeps a non-round route along with its way back, while only the way there is given on input
+        const size_t stops_count = bus->round_route ? bus->stops.size() : bus->stops.size() / 2 + 1;
+        writer.WriteString(bus->name);
+        writer.WriteNumber(static_cast<uint8_t>(bus->round_route));
+        writer.WriteNumber(static_cast<uint32_t>(stops_count));
+        for (size_t i = 0; i < stops_count; ++i) {
+            writer.WriteNumber(stop_indices[bus->stops[i]]);
+        }
+    }
+
+    writer.WriteDict(settings.render_settings);
+    writer.WriteDict(settings.routing_settings);
+    writer.Close();
+}
+
+BaseSettings LoadBase(const std::string& path, Transportation::TransportCatalogue& transp_db) {
+    BaseReader reader(path);
+    char magic[sizeof(BASE_MAGIC)];
+    reader.Read(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(BASE_MAGIC)) || reader.ReadNumber<uint32_t>() != BASE_VERSION) {
+        throw std::runtime_error("Not a database file of version " + std::to_string(BASE_VERSION) + ": " + path);
+    }
+
+    std::vector<Stop*> stops(reader.ReadNumber<uint32_t>());
+    for (Stop*& stop : stops) {
+        std::string name = reader.ReadString();
+        const double lat = reader.ReadNumber<double>();
+        const double lng = reader.ReadNumber<double>();
+        transp_db.AddStop(std::string(name), {lat, lng});
+        stop = transp_db.FindStop(name);
+    }
+    const auto read_stop = [&]() {
+        const uint32_t index = reader.ReadNumber<uint32_t>();
+        if (index >= stops.size()) {
+            throw std::runtime_error("Malformed database file");
+        }
+        return stops[index];
+    };
+
+    for (uint32_t i = reader.ReadNumber<uint32_t>(); i > 0; --i) {
+        const Stop* from = read_stop();
+        const Stop* to = read_stop();
+        transp_db.SetStopDistance(from, to, reader.ReadNumber<int32_t>());
+    }
+
+    for (uint32_t i = reader.ReadNumber<uint32_t>(); i > 0; --i) {
+        std::string name = reader.ReadString();
+        const bool round_route = reader.ReadNumber<uint8_t>() != 0;
+        std::vector<Stop*> bus_stops(reader.ReadNumber<uint32_t>());
+        for (Stop*& stop : bus_stops) {
+            stop = read_stop();
+        }
+        transp_db.AddBus(std::move(name), std::move(bus_stops), round_route);
+    }
+    transp_db.Finalize();
+
+    BaseSettings settings;
+    settings.render_settings = reader.ReadDict();
+    settings.routing_settings = reader.ReadDict();
+    return settings;
+}
+
+}  // namespace serialization
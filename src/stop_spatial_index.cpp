@@ -0,0 +1,235 @@
+#define _USE_MATH_DEFINES
+#include "headers/stop_spatial_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Transportation{
+
+namespace {
+
+constexpr double STOPS_PER_CELL = 2.0;
+constexpr double DEGREES_PER_RADIAN = 180.0 / M_PI;
+constexpr double BOX_MARGIN = 1e-5; // in degrees, about a meter: wider than the rounding errors of geo::ComputeDistance
+constexpr double HALF_CIRCUMFERENCE = M_PI * geo::EARTH_RADIUS; // no two points are farther apart
+
+bool IsCloser(const NearbyStop& left, const NearbyStop& right){
+    return left.distance < right.distance || (left.distance == right.distance && left.stop->name < right.stop->name);
+}
+
+} // namespace
+
+StopSpatialIndex::StopSpatialIndex(const std::vector<const Stop*>& stops){
+    if (stops.empty()){
+        return;
+    }
+    geo::Coordinates max_coordinates = stops.front()->coordinates;
+    min_coordinates_ = stops.front()->coordinates;
+    for (const Stop* stop : stops){
+        min_coordinates_.lat = std::min(min_coordinates_.lat, stop->coordinates.lat);
+        min_coordinates_.lng = std::min(min_coordinates_.lng, stop->coordinates.lng);
+        max_coordinates.lat = std::max(max_coordinates.lat, stop->coordinates.lat);
+        max_coordinates.lng = std::max(max_coordinates.lng, stop->coordinates.lng);
+    }
+
+    // cells are about square on the ground: a degree of longitude is shorter than a degree of latitude away from the equator
+    const double height = max_coordinates.lat - min_coordinates_.lat;
+    const double width = (max_coordinates.lng - min_coordinates_.lng)
+                         * std::max(std::cos((min_coordinates_.lat + max_coordinates.lat) / 2 / DEGREES_PER_RADIAN), 0.01);
+    const double cell_count = std::max(1.0, std::ceil(stops.size() / STOPS_PER_CELL));
+    if (height > 0 && width > 0){
+        rows_ = std::max<size_t>(1, static_cast<size_t>(std::round(std::sqrt(cell_count * height / width))));
+        columns_ = std::max<size_t>(1, static_cast<size_t>(std::round(cell_count / rows_)));
+    }
+    else{ // the stops are on a line, or all at the same point
+        rows_ = height > 0 ? static_cast<size_t>(cell_count) : 1;
+        columns_ = width > 0 ? static_cast<size_t>(cell_count) : 1;
+    }
+    cell_height_ = height > 0 ? height / rows_ : 1.0;
+    cell_width_ = max_coordinates.lng > min_coordinates_.lng ? (max_coordinates.lng - min_coordinates_.lng) / columns_ : 1.0;
+
+    std::vector<size_t> stop_cells(stops.size());
+    cell_offsets_.assign(rows_ * columns_ + 1, 0);
+    for (size_t i = 0; i < stops.size(); ++i){
+        stop_cells[i] = GetRow(stops[i]->coordinates.lat) * columns_ + GetColumn(stops[i]->coordinates.lng);
+        ++cell_offsets_[stop_cells[i] + 1];
+    }
+    for (size_t cell = 0; cell < rows_ * columns_; ++cell){
+        cell_offsets_[cell + 1] += cell_offsets_[cell];
+    }
+    cell_stops_.resize(stops.size());
+    cell_coordinates_.resize(stops.size());
+    std::vector<size_t> fill_positions(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t i = 0; i < stops.size(); ++i){
+        const size_t position = fill_positions[stop_cells[i]]++;
+        cell_stops_[position] = stops[i];
+        cell_coordinates_[position] = stops[i]->coordinates;
+    }
+}
+
+std::vector<NearbyStop> StopSpatialIndex::FindInRadius(geo::Coordinates center, double radius) const{
+    std::vector<NearbyStop> found;
+    if (cell_stops_.empty() || !(radius >= 0)){
+        return found;
+    }
+
+    // a point within the radius is at most `angle` away in latitude, and at most asin(sin(angle) / cos(lat)) in longitude,
+    // unless the circle reaches a pole
+    const double angle = std::min(radius, HALF_CIRCUMFERENCE) / geo::EARTH_RADIUS;
+    const double center_lat = center.lat / DEGREES_PER_RADIAN;
+    const double min_lat = center.lat - angle * DEGREES_PER_RADIAN - BOX_MARGIN;
+    const double max_lat = center.lat + angle * DEGREES_PER_RADIAN + BOX_MARGIN;
+    if (max_lat < min_coordinates_.lat || min_lat > min_coordinates_.lat + cell_height_ * rows_ + BOX_MARGIN){
+        return found;
+    }
+    size_t first_column = 0;
+    size_t last_column = columns_ - 1;
+    if (angle < M_PI / 2 - std::abs(center_lat)){
+        const double lng_delta = std::asin(std::sin(angle) / std::cos(center_lat)) * DEGREES_PER_RADIAN + BOX_MARGIN;
+        if (center.lng - lng_delta >= -180 && center.lng + lng_delta <= 180){ // otherwise the circle wraps around the antimeridian
+            if (center.lng + lng_delta < min_coordinates_.lng || center.lng - lng_delta > min_coordinates_.lng + cell_width_ * columns_ + BOX_MARGIN){
+                return found;
+            }
+            first_column = GetColumn(center.lng - lng_delta);
+            last_column = GetColumn(center.lng + lng_delta);
+        }
+    }
+
+    for (size_t row = GetRow(min_lat), last_row = GetRow(max_lat); row <= last_row; ++row){
+        // cells of a row are adjacent, so the stops of the columns scanned are a single range
+        const size_t first = cell_offsets_[row * columns_ + first_column];
+        const size_t last = cell_offsets_[row * columns_ + last_column + 1];
+        for (size_t i = first; i < last; ++i){
+            const double distance = geo::ComputeDistance(center, cell_coordinates_[i]);
+            if (distance <= radius){
+                found.push_back({cell_stops_[i], distance});
+            }
+        }
+    }
+    std::sort(found.begin(), found.end(), IsCloser);
+    return found;
+}
+
+std::vector<NearbyStop> StopSpatialIndex::FindNearest(geo::Coordinates center, size_t count) const{
+    if (count == 0 || cell_stops_.empty()){
+        return {};
+    }
+    // the stops found within a radius are the closest ones, so the radius is widened until it takes in enough of them;
+    // it starts from the side of a square holding `count` cells
+    const double cell_side = std::max(cell_height_ / DEGREES_PER_RADIAN * geo::EARTH_RADIUS, 1.0);
+    double radius = cell_side * std::sqrt(count / STOPS_PER_CELL);
+    while (true){
+        std::vector<NearbyStop> found = FindInRadius(center, radius);
+        if (found.size() >= count || radius >= HALF_CIRCUMFERENCE){
+            found.resize(std::min(found.size(), count));
+            return found;
+        }
+        radius *= 2;
+    }
+}
+
+size_t StopSpatialIndex::GetRow(double lat) const{
+    const double row = std::floor((lat - min_coordinates_.lat) / cell_height_);
+    return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+size_t StopSpatialIndex::GetColumn(double lng) const{
+    const double column = std::floor((lng - min_coordinates_.lng) / cell_width_);
+    return static_cast<size_t>(std::clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+}
+
+std::vector<StopPairDistance> JoinStopsWithinDistance(const std::vector<const Stop*>& stops, double max_distance,
+                                                      SpatialJoinStats* stats){
+    const auto start_time = std::chrono::steady_clock::now();
+    std::vector<StopPairDistance> pairs;
+    SpatialJoinStats join_stats;
+    if (stops.size() < 2 || !(max_distance >= 0)){
+        if (stats){
+            *stats = join_stats;
+        }
+        return pairs;
+    }
+
+    // a cell is at least as high and as wide as the distance anywhere the stops are, so stops within the distance of
+    // each other are in the same or neighbouring cells; columns wrap around the antimeridian
+    const double angle = std::min(max_distance, HALF_CIRCUMFERENCE) / geo::EARTH_RADIUS;
+    double max_abs_lat = 0;
+    for (const Stop* stop : stops){
+        max_abs_lat = std::max(max_abs_lat, std::abs(stop->coordinates.lat));
+    }
+    const double cell_height = angle * DEGREES_PER_RADIAN + BOX_MARGIN;
+    size_t columns = 1;
+    if (angle < M_PI / 2 - max_abs_lat / DEGREES_PER_RADIAN){
+        const double lng_delta = std::asin(std::sin(angle) / std::cos(max_abs_lat / DEGREES_PER_RADIAN)) * DEGREES_PER_RADIAN + BOX_MARGIN;
+        columns = static_cast<size_t>(360 / lng_delta);
+        if (columns < 3){ // the left and the right neighbours would be the same cell
+            columns = 1;
+        }
+    }
+    const double cell_width = 360.0 / columns;
+    const auto get_cell = [&](int64_t row, int64_t column){
+        return static_cast<uint64_t>(row) << 32 | static_cast<uint64_t>((column + columns) % columns);
+    };
+
+    std::vector<std::pair<uint64_t, const Stop*>> cell_stops;
+    cell_stops.reserve(stops.size());
+    for (const Stop* stop : stops){
+        const int64_t row = static_cast<int64_t>(std::floor((stop->coordinates.lat + 90) / cell_height));
+        const int64_t column = static_cast<int64_t>(std::floor((stop->coordinates.lng + 180) / cell_width));
+        cell_stops.emplace_back(get_cell(row, column), stop);
+    }
+    std::sort(cell_stops.begin(), cell_stops.end(), [](const auto& lhs, const auto& rhs){ return lhs.first < rhs.first; });
+    std::unordered_map<uint64_t, std::pair<size_t, size_t>> cell_ranges; // [first, last) in cell_stops
+    for (size_t i = 0; i < cell_stops.size(); ++i){
+        auto [it, inserted] = cell_ranges.try_emplace(cell_stops[i].first, i, i + 1);
+        it->second.second = i + 1;
+    }
+
+    const auto compare = [&](size_t first, size_t second){
+        const double distance = geo::ComputeDistance(cell_stops[first].second->coordinates, cell_stops[second].second->coordinates);
+        ++join_stats.compared_pairs;
+        if (distance <= max_distance){
+            pairs.push_back({cell_stops[first].second, cell_stops[second].second, distance});
+        }
+    };
+    for (const auto& [cell, range] : cell_ranges){
+        for (size_t i = range.first; i < range.second; ++i){ // pairs within the cell
+            for (size_t j = i + 1; j < range.second; ++j){
+                compare(i, j);
+            }
+        }
+        // pairs with the neighbours east and north of the cell, so that every pair of cells is visited once
+        const int64_t row = static_cast<int64_t>(cell >> 32);
+        const int64_t column = static_cast<int64_t>(cell & 0xFFFFFFFFu);
+        std::vector<uint64_t> neighbours;
+        if (columns > 1){
+            neighbours = {get_cell(row, column + 1), get_cell(row + 1, column - 1), get_cell(row + 1, column), get_cell(row + 1, column + 1)};
+        }
+        else{
+            neighbours = {get_cell(row + 1, column)};
+        }
+        for (const uint64_t neighbour : neighbours){
+            const auto it = cell_ranges.find(neighbour);
+            if (it == cell_ranges.end()){
+                continue;
+            }
+            for (size_t i = range.first; i < range.second; ++i){
+                for (size_t j = it->second.first; j < it->second.second; ++j){
+                    compare(i, j);
+                }
+            }
+        }
+    }
+
+    if (stats){
+        join_stats.found_pairs = pairs.size();
+        join_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        *stats = join_stats;
+    }
+    return pairs;
+}
+
+} // namespace Transportation
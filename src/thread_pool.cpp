@@ -0,0 +1,93 @@
+#include "headers/thread_pool.h"
+
+namespace threading{
+
+ThreadPool::ThreadPool(size_t thread_count){
+    for (size_t i = 1; i < thread_count; ++i){ // the calling thread is the first one
+        workers_.emplace_back([this](){ WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    batch_started_.notify_all();
+    for (std::thread& worker : workers_){
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const noexcept{
+    return workers_.size() + 1;
+}
+
+size_t ThreadPool::GetDefaultThreadCount() noexcept{
+    const size_t hardware_threads = std::thread::hardware_concurrency();
+    return hardware_threads > 0 ? hardware_threads : 1;
+}
+
+void ThreadPool::ParallelFor(size_t task_count, const std::function<void(size_t)>& task){
+    if (workers_.empty() || task_count < 2){
+        for (size_t i = 0; i < task_count; ++i){
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &task;
+        task_count_ = task_count;
+        next_task_ = 0;
+        unfinished_tasks_ = task_count;
+        ++batch_number_;
+    }
+    batch_started_.notify_all();
+
+    RunTasks();
+
+    std::unique_lock lock(mutex_);
+    batch_finished_.wait(lock, [this](){ return unfinished_tasks_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::RunTasks(){
+    while (true){
+        const std::function<void(size_t)>* task = nullptr;
+        size_t task_index = 0;
+        {
+            std::lock_guard lock(mutex_);
+            if (!task_ || next_task_ >= task_count_){
+                return;
+            }
+            task = task_;
+            task_index = next_task_++;
+        }
+
+        (*task)(task_index);
+
+        std::lock_guard lock(mutex_);
+        if (--unfinished_tasks_ == 0){
+            batch_finished_.notify_all();
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop(){
+    size_t last_batch_number = 0;
+    while (true){
+        {
+            std::unique_lock lock(mutex_);
+            batch_started_.wait(lock, [&](){ return stopping_ || batch_number_ != last_batch_number; });
+            if (stopping_){
+                return;
+            }
+            last_batch_number = batch_number_;
+        }
+        RunTasks();
+    }
+}
+
+} // namespace threading
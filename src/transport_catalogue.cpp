@@ -6,11 +6,25 @@ namespace Transportation{
             str = str.substr(str.find_first_not_of(' '));
             str = str.substr(0, str.find_last_not_of(' ') + 1);
         }
+    }
 
-        size_t StopPairHasher::operator()(const std::pair<const Stop*, const Stop*> hashing_pair) const noexcept{
-            uint64_t num = std::hash<const void*>{}(hashing_pair.first) * 2 + std::hash<const void*>{}(hashing_pair.second) * 8;
-            return static_cast<size_t>(num);
+    TransportCatalogue::TransportCatalogue(const TransportCatalogue& other)
+        : stops_(other.stops_), buses_(other.buses_), stop_coordinates_(other.stop_coordinates_),
+          stop_prepared_coordinates_(other.stop_prepared_coordinates_), stoppair_to_distance_(other.stoppair_to_distance_){
+        for (Stop& stop : stops_){ // in id order, so a name taken by several stops maps to the last one, as it does in `other`
+            stopname_to_stop_[std::string_view(stop.name)] = &stop;
+        }
+        for (Bus& bus : buses_){
+            busname_to_bus_[std::string_view(bus.name)] = &bus;
+        }
+        stop_to_buses_.reserve(other.stop_to_buses_.size());
+        for (const std::deque<Bus*>& other_buses : other.stop_to_buses_){
+            std::deque<Bus*>& buses = stop_to_buses_.emplace_back();
+            for (const Bus* bus : other_buses){
+                buses.push_back(&buses_[bus->id]);
+            }
         }
+        // the indices point into `other` and are left to be rebuilt by Finalize, once the copy has been changed
     }
 
     void TransportCatalogue::AddStop(std::string&& stop_name, const geo::Coordinates& coords){
@@ -19,10 +33,13 @@ namespace Transportation{
         if (stop && stop->coordinates == coords){
             return;
         }
-        stops_.push_back({stop_name, coords});
-        Stop* stop_element = &stops_[stops_.size() - 1];
-        stop_to_buses_[stop_element];
+        stops_.push_back({stop_name, coords, static_cast<StopId>(stops_.size())});
+        Stop* stop_element = &stops_.back();
+        stop_coordinates_.push_back(coords);
+        stop_prepared_coordinates_.push_back(geo::PrepareCoordinates(coords));
+        stop_to_buses_.emplace_back();
         stopname_to_stop_[std::string_view(stop_element->name)] = stop_element;
+        is_finalized_ = false; // the indices are rebuilt once, by the next Finalize
     }
 
 
@@ -31,48 +48,106 @@ namespace Transportation{
         if (busname_to_bus_.count(bus_name)){ 
             return; 
         } 
-        double C_route_length = CountRouteLength(stops, round_route); 
-        std::vector<Stop*> reversed_route(stops.begin(), stops.begin() + stops.size() - (round_route == true ? 0 : 1));             
+        std::vector<StopId> stop_ids;
+        stop_ids.reserve(stops.size());
+        for (const Stop* stop : stops){
+            if (stop){
+                stop_ids.push_back(stop->id);
+            }
+        }
+        double C_route_length = CountRouteLength(stop_ids, round_route); 
+        std::vector<StopId> reversed_route(stop_ids.begin(), stop_ids.begin() + stop_ids.size() - (round_route == true || stop_ids.empty() ? 0 : 1));             
         if (!round_route){ 
-            reversed_route.insert(reversed_route.end(), stops.rbegin(), stops.rend()); 
+            reversed_route.insert(reversed_route.end(), stop_ids.rbegin(), stop_ids.rend()); 
         } 
         if (reversed_route.empty()){
             return;
         }
 
-        buses_.push_back({bus_name, std::move(reversed_route), C_route_length, round_route}); 
+        buses_.push_back({bus_name, std::move(reversed_route), C_route_length, round_route, static_cast<BusId>(buses_.size())}); 
         Bus* bus_element = &buses_.back(); 
+        UpdateBusStats(*bus_element);
 
-        std::unordered_set<Stop*> tmp_stops; 
-        for (Stop* stop : stops){ 
-            if (stop_to_buses_.count(stop) && tmp_stops.count(stop) == 0){ 
-                stop_to_buses_[stop].push_back(bus_element); 
-                tmp_stops.insert(stop); 
+        for (const StopId stop : stop_ids){ 
+            std::deque<Bus*>& stop_buses = stop_to_buses_[stop];
+            if (stop_buses.empty() || stop_buses.back() != bus_element){ // the bus is listed last if it passes the stop again
+                stop_buses.push_back(bus_element); 
             } 
         } 
         busname_to_bus_[std::string_view(bus_element->name)] = bus_element; 
+        is_finalized_ = false;
     }
 
-    BusResponse TransportCatalogue::GetRoute(std::string_view bus_name) const noexcept{ 
-        assert(!bus_name.empty()); 
-        if (busname_to_bus_.count(bus_name)){ 
+    void TransportCatalogue::Finalize(){
+        if (is_finalized_){
+            return;
+        }
+        BuildIndices();
+        is_finalized_ = true;
+    }
 
-            Bus* bus = busname_to_bus_.at(bus_name); 
-            std::vector<Stop*>& stops = bus->stops; 
-            double L_route_length = 0;  
-            size_t stops_count = stops.size();  
+    void TransportCatalogue::BuildIndices(){
+        const auto by_name = [](const auto* left, const auto* right){ return left->name < right->name; };
 
-            for (size_t i = 0; i < stops_count - 1; ++i){  
-                unsigned int dist = GetStopDistance(stops[i], stops[i + 1]);  
-                L_route_length += dist;  
-            } 
+        stop_buses_offsets_.assign(1, 0);
+        stop_buses_offsets_.reserve(stop_to_buses_.size() + 1);
+        stop_buses_.clear();
+        for (const std::deque<Bus*>& buses : stop_to_buses_){
+            const auto first_bus = stop_buses_.insert(stop_buses_.end(), buses.begin(), buses.end());
+            std::sort(first_bus, stop_buses_.end(), by_name);
+            stop_buses_offsets_.push_back(stop_buses_.size());
+        }
 
-            std::unordered_set<Stop*> unique_stops(stops.begin(), stops.end()); 
-            return {std::string_view(bus->name), stops.size(), unique_stops.size(), L_route_length, (L_route_length / (bus->C_route_length * 1.0))}; 
+        sorted_stops_.clear();
+        sorted_stops_.reserve(stops_.size());
+        for (const Stop& stop : stops_){
+            sorted_stops_.push_back(&stop);
+        }
+        std::sort(std::execution::par, sorted_stops_.begin(), sorted_stops_.end(), by_name);
+
+        used_stops_.clear();
+        std::copy_if(sorted_stops_.begin(), sorted_stops_.end(), std::back_inserter(used_stops_),
+                     [this](const Stop* stop){ return StopIsUsed(stop); });
+
+        sorted_buses_.clear();
+        sorted_buses_.reserve(buses_.size());
+        for (const Bus& bus : buses_){
+            sorted_buses_.push_back(&bus);
+        }
+        std::sort(std::execution::par, sorted_buses_.begin(), sorted_buses_.end(), by_name);
+
+        stops_index_ = StopSpatialIndex(sorted_stops_);
+    }
+
+    void TransportCatalogue::CheckFinalized() const{
+        if (!is_finalized_){
+            throw std::logic_error("[!] The catalogue must be finalized before querying it, and again after adding stops or buses.");
+        }
+    }
+
+    BusResponse TransportCatalogue::GetRoute(std::string_view bus_name) const noexcept{ 
+        assert(!bus_name.empty()); 
+        if (const auto it = busname_to_bus_.find(bus_name); it != busname_to_bus_.end()){ 
+            const Bus* bus = it->second; 
+            return {std::string_view(bus->name), bus->stops.size(), bus->unique_stops_count, bus->L_route_length, bus->curvature}; 
         } 
         return {bus_name}; 
     } 
 
+    void TransportCatalogue::UpdateBusStats(Bus& bus) const{
+        const std::vector<StopId>& stops = bus.stops;
+        double L_route_length = 0;
+        for (size_t i = 0; i + 1 < stops.size(); ++i){
+            L_route_length += GetStopDistance(stops[i], stops[i + 1]);
+        }
+        bus.L_route_length = L_route_length;
+        bus.curvature = L_route_length / bus.C_route_length;
+
+        std::vector<StopId> unique_stops(stops);
+        std::sort(unique_stops.begin(), unique_stops.end());
+        bus.unique_stops_count = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
+    }
+
     Stop* TransportCatalogue::FindStop(std::string_view stop_name) const noexcept{
         assert(!stop_name.empty());
         if (stopname_to_stop_.count(stop_name)){
@@ -83,22 +158,47 @@ namespace Transportation{
 
     void TransportCatalogue::SetStopDistance(const Stop* first_stop, const Stop* second_stop, const int distance){
         if (first_stop != nullptr && second_stop != nullptr){
-            stoppair_to_distance_[{first_stop, second_stop}] = distance;
+            stoppair_to_distance_.Set(first_stop->id, second_stop->id, distance);
+            for (Bus* bus : stop_to_buses_[first_stop->id]){ // both directions between the stops are ridden only by buses passing the first one
+                UpdateBusStats(*bus);
+            }
         }
     }
 
     int TransportCatalogue::GetStopDistance(const Stop* first_stop, const Stop* second_stop) const noexcept{
         if (first_stop != nullptr && second_stop != nullptr){
-            if (stoppair_to_distance_.count({first_stop, second_stop})){
-                return stoppair_to_distance_.at({first_stop, second_stop});
-            }
-            else if (stoppair_to_distance_.count({second_stop, first_stop})){
-                return stoppair_to_distance_.at({second_stop, first_stop});
-            }
+            return GetStopDistance(first_stop->id, second_stop->id);
         }
         return 0;
     }
 
+    int TransportCatalogue::GetStopDistance(StopId first_stop, StopId second_stop) const noexcept{
+        return stoppair_to_distance_.Get(first_stop, second_stop);
+    }
+
+    const Stop& TransportCatalogue::GetStop(StopId id) const noexcept{
+        assert(id < stops_.size());
+        return stops_[id];
+    }
+
+    const Bus& TransportCatalogue::GetBus(BusId id) const noexcept{
+        assert(id < buses_.size());
+        return buses_[id];
+    }
+
+    const std::vector<geo::Coordinates>& TransportCatalogue::GetStopsCoordinates() const noexcept{
+        return stop_coordinates_;
+    }
+
+    std::vector<StopDistance> TransportCatalogue::GetAllStopDistances() const noexcept{
+        std::vector<StopDistance> distances;
+        distances.reserve(stoppair_to_distance_.GetSize());
+        stoppair_to_distance_.ForEach([&](StopId from, StopId to, int distance){
+            distances.push_back({&stops_[from], &stops_[to], distance});
+        });
+        return distances;
+    }
+
     size_t TransportCatalogue::GetStopCount() const noexcept{
         return stops_.size();
     }
@@ -106,48 +206,40 @@ namespace Transportation{
         return buses_.size();
     }
 
-    const std::deque<Bus*>& TransportCatalogue::GetStopBusesList(const Stop* stop) noexcept{
-        bool stop_exists = stop_to_buses_.count(stop) > 0;
-        if (stop_exists){
-            std::deque<Bus*>& stop_buses_list = stop_to_buses_.at(stop);
-            std::sort(std::execution::par, stop_buses_list.begin(), stop_buses_list.end(), [](const Bus* left, const Bus* right){ return left->name < right->name; });
-            return stop_buses_list;
+    TransportCatalogue::BusesRange TransportCatalogue::GetStopBusesList(const Stop* stop) const{
+        CheckFinalized();
+        if (stop == nullptr){
+            return {stop_buses_.end(), stop_buses_.end()};
         }
-        return dummy_map_;
+        return {stop_buses_.begin() + stop_buses_offsets_[stop->id], stop_buses_.begin() + stop_buses_offsets_[stop->id + 1]};
     }
 
-    std::vector<const Bus*> TransportCatalogue::GetAllBuses() const noexcept{
-        std::vector<const Bus*> buses_list;
-        for (const Bus& bus : buses_){
-            buses_list.push_back(&bus);
-        }
-        std::sort(std::execution::par, buses_list.begin(), buses_list.end(), [](const Bus* left, const Bus* right){ return left->name < right->name; });
-        return buses_list;
+    const std::vector<const Bus*>& TransportCatalogue::GetAllBuses() const{
+        CheckFinalized();
+        return sorted_buses_;
     }
 
-    std::vector<const Stop*> TransportCatalogue::GetAllStops() const noexcept{
-        std::vector<const Stop*> stops;
-        stops.reserve(stop_to_buses_.size());
-        for (const auto& [stop, buses] : stop_to_buses_){
-            stops.push_back(stop);
-        }
-        std::sort(std::execution::par, stops.begin(), stops.end(), [](const Stop* left, const Stop* right){ return left->name < right->name; });
-        return stops;
+    const std::vector<const Stop*>& TransportCatalogue::GetAllStops() const{
+        CheckFinalized();
+        return sorted_stops_;
     }
 
-    std::vector<const Stop*> TransportCatalogue::GetUsedStops() const noexcept{
-        std::vector<const Stop*> used_stops;
-        used_stops.reserve(stops_.size());
-        for (const Stop* stop : GetAllStops()){
-            if (StopIsUsed(stop)){
-                used_stops.push_back(stop);
-            }
-        }
-        std::sort(std::execution::par, used_stops.begin(), used_stops.end(), [](const Stop* left, const Stop* right){ return left->name < right->name; });
-        return used_stops;
+    const std::vector<const Stop*>& TransportCatalogue::GetUsedStops() const{
+        CheckFinalized();
+        return used_stops_;
     }
 
     bool TransportCatalogue::StopIsUsed(const Stop* stop) const noexcept{
-        return stop_to_buses_.count(stop) && !stop_to_buses_.at(stop).empty();
+        return stop != nullptr && !stop_to_buses_[stop->id].empty();
+    }
+
+    std::vector<NearbyStop> TransportCatalogue::FindStopsInRadius(geo::Coordinates center, double radius) const{
+        CheckFinalized();
+        return stops_index_.FindInRadius(center, radius);
+    }
+
+    std::vector<NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates center, size_t count) const{
+        CheckFinalized();
+        return stops_index_.FindNearest(center, count);
     }
 }
\ No newline at end of file
@@ -1,26 +1,267 @@
 #include "headers/transport_router.h"
 
+#include <chrono>
+#include <utility>
+
 namespace Transportation{
 
+namespace {
+
+double GetSecondsSince(std::chrono::steady_clock::time_point start_time){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+} // namespace
+
+Router::Router(RouterConfig&& config, const TransportCatalogue& transp_db) : config_(std::move(config)){
+    if (config_.snapshot_file.empty()){
+        BuildGraph(transp_db);
+        return;
+    }
+    if (config_.backend != RouterBackend::ALL_PAIRS && config_.backend != RouterBackend::ALL_PAIRS_COMPACT){
+        throw std::logic_error("[!] Only all-pairs routes can be saved to a snapshot.");
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t fingerprint = RouterSnapshot::ComputeFingerprint(config_, transp_db);
+    snapshot_ = RouterSnapshot::Open(config_.snapshot_file, fingerprint);
+    if (snapshot_){
+        raptor_ = std::make_unique<RaptorRouter>(config_, transp_db); // multi-criteria requests are not precomputed
+        build_seconds_ = GetSecondsSince(start_time);
+        return;
+    }
+
+    BuildGraph(transp_db); // the snapshot is missing or outdated
+    WriteSnapshot(fingerprint);
+}
+
+void Router::WriteSnapshot(uint64_t fingerprint) const{
+    if (config_.backend == RouterBackend::ALL_PAIRS_COMPACT){
+        const graph::CompactRouteTable<double>& route_table = static_cast<const CompactAllPairsRouter&>(*router_).GetRouteTable();
+        RouterSnapshot::Write(config_.snapshot_file, fingerprint, stop_names_, edge_items_, graph_, route_table.GetPrevEdges(), {});
+        return;
+    }
+    if (graph_.GetEdgeCount() >= RouterSnapshot::NO_EDGE){
+        throw std::length_error("[!] Too many edges for a snapshot.");
+    }
+    const graph::ExactRouteTable<double>& route_table = static_cast<const AllPairsRouter&>(*router_).GetRouteTable();
+    const size_t cell_count = graph_.GetVertexCount() * graph_.GetVertexCount();
+    std::vector<uint32_t> prev_edges(cell_count, RouterSnapshot::NO_EDGE);
+    std::vector<double> weights(cell_count, 0.0);
+    for (size_t cell = 0; cell < cell_count; ++cell){
+        if (!route_table.HasRoute(cell)){
+            continue;
+        }
+        weights[cell] = route_table.GetWeight(cell);
+        if (const std::optional<graph::EdgeId> prev_edge = route_table.GetPrevEdge(cell)){
+            prev_edges[cell] = static_cast<uint32_t>(*prev_edge);
+        }
+    }
+    RouterSnapshot::Write(config_.snapshot_file, fingerprint, stop_names_, edge_items_, graph_, prev_edges, weights);
+}
+
 void Router::BuildGraph(const TransportCatalogue& transp_db){
-    const std::vector<const Stop*> stops_list = transp_db.GetAllStops();
-    const std::vector<const Bus*> buses_list = transp_db.GetAllBuses();
-    Graph init_graph(stops_list.size() * 2);
+    const auto start_time = std::chrono::steady_clock::now();
+    snapshot_.reset();
+    raptor_ = std::make_unique<RaptorRouter>(config_, transp_db); // cheap to build, as it is linear in the routes length
+    if (config_.backend == RouterBackend::RAPTOR){
+        build_seconds_ = GetSecondsSince(start_time);
+        return;
+    }
+
+    const std::vector<const Stop*>& stops_list = transp_db.GetAllStops();
+    const std::vector<const Bus*>& buses_list = transp_db.GetAllBuses();
+    init_graph_ = Graph(stops_list.size() * 2);
+    vid_to_coordinates_.clear();
+    stopname_to_vid_.clear();
+    stopid_to_vid_.clear();
+    stop_names_.clear();
+    edge_items_.clear();
+    bus_edges_.clear();
+    min_minutes_per_meter_ = std::numeric_limits<double>::infinity();
+
+    CreateStopEdges(stops_list, init_graph_); // creating two edges for one stop: start and boarding
+    CreateRouteEdges(transp_db, buses_list, init_graph_); // creating routes for the stop edges
+    if (config_.HasWalking()){
+        CreateWalkEdges(stops_list, init_graph_); // creating walks between nearby stops
+    }
+    added_edges_.clear(); // the graph router is built over all of them
+
+    graph_ = init_graph_.Freeze();
+    router_ = CreateInRouter();
+
+    const bool searches_on_demand = config_.backend == RouterBackend::DIJKSTRA || config_.backend == RouterBackend::A_STAR
+                                    || config_.backend == RouterBackend::BIDIRECTIONAL;
+    // a budget not fitting a single tree would only make every query search the whole graph
+    if (searches_on_demand && config_.route_cache_size > 0
+        && config_.route_cache_size >= graph::ShortestPathTree<double>::GetMemoryUsage(graph_.GetVertexCount())){
+        route_cache_ = std::make_unique<graph::RouteCache<double>>(config_.route_cache_size);
+    }
+    build_seconds_ = GetSecondsSince(start_time);
+}
+
+void Router::CheckUpdatable() const{
+    if (snapshot_){
+        throw std::logic_error("[!] Routes served from a snapshot can't be updated.");
+    }
+}
+
+RouterUpdateStats Router::AddStop(const Stop* stop){
+    const auto start_time = std::chrono::steady_clock::now();
+    CheckUpdatable();
+    AddStopToGraph(stop);
+
+    RouterUpdateStats stats;
+    UpdateGraph({}, stats);
+    stats.seconds = GetSecondsSince(start_time);
+    return stats;
+}
+
+RouterUpdateStats Router::AddBus(const Bus* bus, const TransportCatalogue& transp_db){
+    const auto start_time = std::chrono::steady_clock::now();
+    CheckUpdatable();
+    if (raptor_->HasBus(bus->name)){
+        throw std::logic_error("[!] The bus has already been added to the router.");
+    }
+    for (const StopId stop_id : bus->stops){
+        const Stop* stop = &transp_db.GetStop(stop_id);
+        if (!raptor_->HasStop(stop->name)){
+            AddStopToGraph(stop);
+        }
+    }
+    raptor_->AddBus(bus, transp_db);
+    if (config_.backend != RouterBackend::RAPTOR){
+        CreateRouteEdges(transp_db, {bus}, init_graph_);
+    }
+
+    RouterUpdateStats stats;
+    UpdateGraph({}, stats);
+    stats.seconds = GetSecondsSince(start_time);
+    return stats;
+}
+
+RouterUpdateStats Router::RemoveBus(std::string_view bus_name){
+    const auto start_time = std::chrono::steady_clock::now();
+    CheckUpdatable();
+    raptor_->RemoveBus(bus_name);
+    std::vector<graph::EdgeId> removed_edges;
+    if (const auto it = bus_edges_.find(bus_name); it != bus_edges_.end()){
+        removed_edges = std::move(it->second);
+        init_graph_.RemoveEdges(removed_edges); // their ids go to the edges added next
+        bus_edges_.erase(it);
+    }
+
+    RouterUpdateStats stats;
+    UpdateGraph(removed_edges, stats);
+    stats.seconds = GetSecondsSince(start_time);
+    return stats;
+}
+
+void Router::AddStopToGraph(const Stop* stop){
+    raptor_->AddStop(stop);
+    if (config_.backend == RouterBackend::RAPTOR){
+        return;
+    }
+    init_graph_.AddVertex(); // arrival
+    init_graph_.AddVertex(); // boarding
+    CreateStopEdges({stop}, init_graph_);
+    if (!config_.HasWalking()){
+        return;
+    }
+
+    // a single stop is compared to all of the others, which is as fast as building a grid for the join
+    const auto start_time = std::chrono::steady_clock::now();
+    const graph::VertexId vid = stopid_to_vid_[stop->id];
+    for (graph::VertexId other_vid = 0; other_vid < vid; other_vid += 2){
+        const double distance = geo::ComputeDistance(stop->coordinates, vid_to_coordinates_[other_vid]);
+        if (distance <= config_.max_walk_distance){
+            AddWalkEdge(vid, other_vid, distance, init_graph_);
+            AddWalkEdge(other_vid, vid, distance, init_graph_);
+            walking_stats_.walking_edges += 2;
+        }
+    }
+    walking_stats_.compared_pairs += vid / 2;
+    walking_stats_.seconds += GetSecondsSince(start_time);
+}
+
+void Router::UpdateGraph(const std::vector<graph::EdgeId>& removed_edges, RouterUpdateStats& stats){
+    const std::vector<graph::EdgeId> added_edges = std::exchange(added_edges_, {});
+    stats.added_edges = added_edges.size();
+    stats.removed_edges = removed_edges.size();
+    if (config_.backend == RouterBackend::RAPTOR){
+        return;
+    }
 
+    graph_ = init_graph_.Freeze(); // the graph router refers to graph_, so it is replaced in place
+    if (route_cache_){
+        // removing edges affects the trees routing through them, and adding ones affects the trees they make lighter
+        stats.invalidated_trees = route_cache_->EraseIf([&](const graph::ShortestPathTree<double>& tree){
+            if (tree.GetVertexCount() != graph_.GetVertexCount()){
+                return true;
+            }
+            const bool routes_through_removed = std::any_of(removed_edges.begin(), removed_edges.end(), [&](graph::EdgeId eid){
+                return tree.GetPrevEdge(graph_.GetEdge(eid).to) == eid;
+            });
+            return routes_through_removed || std::any_of(added_edges.begin(), added_edges.end(), [&](graph::EdgeId eid){
+                const Edge& edge = graph_.GetEdge(eid);
+                return tree.HasRoute(edge.from) && (!tree.HasRoute(edge.to) || tree.GetWeight(edge.from) + edge.weight < tree.GetWeight(edge.to));
+            });
+        });
+    }
+    if (!router_->UpdateEdges(added_edges, removed_edges)){
+        router_ = CreateInRouter();
+        stats.rebuilt = true;
+    }
+}
 
-    CreateStopEdges(stops_list, init_graph); // creating two edges for one stop: start and boarding
-    CreateRouteEdges(transp_db, buses_list, init_graph); // creating routes for the stop edges
+std::unique_ptr<Router::InRouter> Router::CreateInRouter() const{
+    switch (config_.backend){
+        case RouterBackend::DIJKSTRA:
+            return std::make_unique<graph::DijkstraRouter<double>>(graph_);
+        case RouterBackend::A_STAR:
+            return std::make_unique<graph::DijkstraRouter<double>>(graph_, graph::SearchMode::A_STAR,
+                [this](graph::VertexId from, graph::VertexId to){ return ComputeTimeLowerBound(from, to); });
+        case RouterBackend::BIDIRECTIONAL:
+            return std::make_unique<graph::DijkstraRouter<double>>(graph_, graph::SearchMode::BIDIRECTIONAL);
+        case RouterBackend::CONTRACTION_HIERARCHY:
+            return std::make_unique<graph::ContractionHierarchyRouter<double>>(graph_);
+        case RouterBackend::ALL_PAIRS_COMPACT:
+            return std::make_unique<CompactAllPairsRouter>(graph_);
+        case RouterBackend::ALL_PAIRS:
+        default:
+            return std::make_unique<AllPairsRouter>(graph_);
+    }
+}
 
-    graph_ = std::move(init_graph);
-    router_ = std::make_unique<InRouter>(graph_);
+void Router::AddEdgeItem(graph::EdgeId eid, const RouteItem& item){
+    assert(eid <= edge_items_.size()); // edges take the ids of removed ones first, so the ids stay dense
+    if (eid == edge_items_.size()){
+        edge_items_.push_back(item);
+    } else{
+        edge_items_[eid] = item;
+    }
+    added_edges_.push_back(eid);
 }
 
+double Router::ComputeTimeLowerBound(graph::VertexId from, graph::VertexId to) const{
+    return geo::ComputeDistance(vid_to_coordinates_[from], vid_to_coordinates_[to]) * min_minutes_per_meter_;
+}
 
 void Router::CreateStopEdges(const std::vector<const Stop*>& stops, Graph& init_graph){
-    graph::VertexId vid = 0;
+    graph::VertexId vid = stop_names_.size() * 2; // vertices of the stops added before go first
 
+    vid_to_coordinates_.reserve(vid_to_coordinates_.size() + stops.size() * 2);
+    stopname_to_vid_.reserve(stopname_to_vid_.size() + stops.size());
+    stop_names_.reserve(stop_names_.size() + stops.size());
+    edge_items_.reserve(edge_items_.size() + stops.size());
     for (const Stop* stop : stops){ 
         stopname_to_vid_[stop->name] = vid;
+        if (stop->id >= stopid_to_vid_.size()){
+            stopid_to_vid_.resize(stop->id + 1, NO_VERTEX);
+        }
+        stopid_to_vid_[stop->id] = vid;
+        stop_names_.push_back(stop->name);
+        vid_to_coordinates_.insert(vid_to_coordinates_.end(), 2, stop->coordinates);
         const graph::EdgeId stop_edge = init_graph.AddEdge({
             .from = vid,
             .to = ++vid,
@@ -28,78 +269,167 @@ void Router::CreateStopEdges(const std::vector<const Stop*>& stops, Graph& init_
             .weight = static_cast<double>(config_.bus_wait_time)
         });
 
-        edgeid_to_item_[stop_edge] = RouteItem{
+        AddEdgeItem(stop_edge, RouteItem{
             .type = RouteItemType::WAIT,
             .name = stop->name,
             .span_count = 0,
             .spent_time = static_cast<double>(config_.bus_wait_time)
-        };
+        });
         ++vid;
     }
 }
 
 void Router::CreateRouteEdges(const TransportCatalogue& transp_db, const std::vector<const Bus*>& buses, Graph& init_graph){
+    const double meters_per_minute = config_.bus_velocity * KMH_TO_MM_COEF;
+    double min_minutes_per_meter = 1.0 / meters_per_minute;
+
+    const auto get_stops_count = [](const Bus* bus){ // since stops in the bus info are stored as they are on the road, we skip the inversed ones
+        if (bus->stops.empty()){
+            return size_t{0};
+        }
+        return bus->round_route ? bus->stops.size() : bus->stops.size() / 2 + 1;
+    };
+
+    size_t route_edges_count = 0; // every stop of a route is bridged to all of the following ones
+    for (const Bus* bus : buses){
+        const size_t stops_count = get_stops_count(bus);
+        route_edges_count += stops_count > 1 ? stops_count * (stops_count - 1) / 2 * (bus->round_route ? 1 : 2) : 0;
+    }
+    init_graph.ReserveEdges(init_graph.GetEdgeCount() + route_edges_count);
+    edge_items_.reserve(edge_items_.size() + route_edges_count);
+
+    std::vector<graph::VertexId> stop_vids;
+    std::vector<double> distances; // road distance from the first stop of a route, prefix sums
+    std::vector<double> inverse_distances; // the same for the opposite direction
     for (const Bus* bus : buses){
-        std::vector<Stop*> bus_stops = bus->stops;
-        if (!bus->round_route){
-            bus_stops.resize(bus_stops.size() / 2 + 1); // since stops in the bus info are stored as they are on the road, we get rid of the inversed ones
+        const size_t stops_count = get_stops_count(bus);
+        const std::vector<StopId>& bus_stops = bus->stops;
+        const std::vector<geo::Coordinates>& stops_coordinates = transp_db.GetStopsCoordinates();
+
+        stop_vids.assign(stops_count, 0);
+        distances.assign(stops_count, 0.0);
+        inverse_distances.assign(stops_count, 0.0);
+        for (size_t i = 0; i < stops_count; ++i){
+            stop_vids[i] = stopid_to_vid_.at(bus_stops[i]);
+            if (i == 0){
+                continue;
+            }
+            const int distance = transp_db.GetStopDistance(bus_stops[i - 1], bus_stops[i]);
+            const int inverse_distance = transp_db.GetStopDistance(bus_stops[i], bus_stops[i - 1]);
+            distances[i] = distances[i - 1] + distance;
+            inverse_distances[i] = inverse_distances[i - 1] + inverse_distance;
+
+            // road distances may be shorter than geographical ones, so the lower bound must account for them
+            const double geo_distance = geo::ComputeDistance(stops_coordinates[bus_stops[i - 1]], stops_coordinates[bus_stops[i]]);
+            if (geo_distance > 0){
+                min_minutes_per_meter = std::min(min_minutes_per_meter, std::min(distance, inverse_distance) / meters_per_minute / geo_distance);
+            }
         }
 
-        size_t stops_count = bus_stops.size();
+        std::vector<graph::EdgeId>& bus_edges = bus_edges_[bus->name];
         for (size_t i = 0; i < stops_count; ++i){ // bridging stops on a route to each other
-            const Stop* first_stop = bus_stops.at(i);
             for (size_t j = i + 1; j < stops_count; ++j){
-                const Stop* second_stop = bus_stops.at(j);
-
-                double time = 0;
-                double inverse_time = 0;
-                for (size_t n = i + 1; n <= j; ++n){ // calculate ride time from one stop to another
-                    time += transp_db.GetStopDistance(bus_stops.at(n - 1), bus_stops.at(n)) / (config_.bus_velocity * KMH_TO_MM_COEF);
-                    inverse_time += transp_db.GetStopDistance(bus_stops.at(n), bus_stops.at(n - 1)) / (config_.bus_velocity * KMH_TO_MM_COEF);
-                }
+                const double time = (distances[j] - distances[i]) / meters_per_minute;
+                const double inverse_time = (inverse_distances[j] - inverse_distances[i]) / meters_per_minute;
 
                 const graph::EdgeId eid = init_graph.AddEdge({ // create an edge from first stop (boarding allias) to the second one (start allias)
-                    .from = stopname_to_vid_.at(first_stop->name) + 1,
-                    .to = stopname_to_vid_.at(second_stop->name),
+                    .from = stop_vids[i] + 1,
+                    .to = stop_vids[j],
                     .span_count = static_cast<int>(j - i),
                     .weight = time
                 });
-                edgeid_to_item_[eid] = RouteItem{ // map edgeID to RouteItem
+                AddEdgeItem(eid, RouteItem{ // map edgeID to RouteItem
                     .type = RouteItemType::BUS,
                     .name = bus->name,
                     .span_count = static_cast<int>(j - i),
                     .spent_time = time
-                };
+                });
+                bus_edges.push_back(eid);
 
                 if (!bus->round_route){ // if the route is not round, then we will construct inverse route from the second stop (boarding) to the first (start)
                     const graph::EdgeId inv_eid = init_graph.AddEdge({
-                        .from = stopname_to_vid_.at(second_stop->name) + 1,
-                        .to = stopname_to_vid_.at(first_stop->name),
+                        .from = stop_vids[j] + 1,
+                        .to = stop_vids[i],
                         .span_count = static_cast<int>(j - i),
                         .weight = inverse_time
                     });
-                    edgeid_to_item_[inv_eid] = RouteItem{
+                    AddEdgeItem(inv_eid, RouteItem{
                         .type = RouteItemType::BUS,
                         .name = bus->name,
                         .span_count = static_cast<int>(j - i),
                         .spent_time = inverse_time
-                    };
+                    });
+                    bus_edges.push_back(inv_eid);
                 }
             }
         } 
     }
+    // keep the bound admissible despite rounding errors; it is only lowered by buses added later, as removed ones leave it admissible
+    min_minutes_per_meter_ = std::min(min_minutes_per_meter_, min_minutes_per_meter * (1.0 - 1e-9));
+}
+
+void Router::CreateWalkEdges(const std::vector<const Stop*>& stops, Graph& init_graph){
+    SpatialJoinStats join_stats;
+    const std::vector<StopPairDistance> pairs = JoinStopsWithinDistance(stops, config_.max_walk_distance, &join_stats);
+    init_graph.ReserveEdges(init_graph.GetEdgeCount() + pairs.size() * 2);
+    edge_items_.reserve(edge_items_.size() + pairs.size() * 2);
+    for (const auto& [first, second, distance] : pairs){
+        AddWalkEdge(stopid_to_vid_[first->id], stopid_to_vid_[second->id], distance, init_graph);
+        AddWalkEdge(stopid_to_vid_[second->id], stopid_to_vid_[first->id], distance, init_graph);
+    }
+    walking_stats_ = WalkingTransferStats{
+        .compared_pairs = join_stats.compared_pairs,
+        .walking_edges = pairs.size() * 2,
+        .seconds = join_stats.seconds
+    };
+    // walks are as long as the geographical distance, so the lower bound may be no higher than the walking pace
+    min_minutes_per_meter_ = std::min(min_minutes_per_meter_, 1.0 / (config_.walking_speed * KMH_TO_MM_COEF) * (1.0 - 1e-9));
+}
+
+void Router::AddWalkEdge(graph::VertexId from, graph::VertexId to, double distance, Graph& init_graph){
+    const double time = distance / (config_.walking_speed * KMH_TO_MM_COEF);
+    const graph::EdgeId eid = init_graph.AddEdge({ // from the arrival vertex to the other arrival one, so a walk is followed by a wait
+        .from = from,
+        .to = to,
+        .span_count = 0,
+        .weight = time
+    });
+    AddEdgeItem(eid, RouteItem{
+        .type = RouteItemType::WALK,
+        .name = stop_names_[to / 2],
+        .span_count = 0,
+        .spent_time = time
+    });
+}
+
+std::optional<WalkingTransferStats> Router::GetWalkingTransferStats() const{
+    if (!config_.HasWalking()){
+        return std::nullopt;
+    }
+    if (config_.backend == RouterBackend::RAPTOR || snapshot_){ // the graph has not been built
+        return raptor_->GetWalkingTransferStats();
+    }
+    return walking_stats_;
 }
 
 RouteResponse Router::FindRoute(const std::string& stop_from, const std::string& stop_to){
+    if (config_.backend == RouterBackend::RAPTOR){
+        return raptor_->FindRoute(stop_from, stop_to);
+    }
+    if (snapshot_){
+        return snapshot_->FindRoute(stop_from, stop_to);
+    }
     if (graph_.GetEdgeCount() == 0){
         return RouteResponse{.error = "[!] The graph contains no connecting edges."};
     }
-    if (!stopname_to_vid_.count(stop_from) || !stopname_to_vid_.count(stop_to)){
+    const auto stop_from_it = stopname_to_vid_.find(stop_from);
+    const auto stop_to_it = stopname_to_vid_.find(stop_to);
+    if (stop_from_it == stopname_to_vid_.end() || stop_to_it == stopname_to_vid_.end()){
         return RouteResponse{.error = "[!] One of the provided stops does not exist."};
     }
 
-    graph::VertexId stop_from_vid = stopname_to_vid_.at(stop_from), stop_to_vid = stopname_to_vid_.at(stop_to);
-    std::optional<InRouter::RouteInfo> built_data = router_->BuildRoute(stop_from_vid, stop_to_vid);
+    size_t settled_count = 0;
+    std::optional<InRouter::RouteInfo> built_data = BuildRoute(stop_from_it->second, stop_to_it->second, settled_count);
 
     if (!built_data){
         return RouteResponse{.error = "[!] Failed to build route."};
@@ -110,11 +440,119 @@ RouteResponse Router::FindRoute(const std::string& stop_from, const std::string&
     resp.total_time = built_data->weight;
     resp.route_items.reserve(built_data->edges.size());
 
+    resp.settled_vertices = settled_count;
+
     for (const graph::EdgeId eid : built_data->edges){
-        resp.route_items.push_back(edgeid_to_item_.at(eid));
+        resp.route_items.push_back(edge_items_[eid]);
     }
 
     return resp;
 }
 
+std::vector<RouteResponse> Router::FindParetoRoutes(const std::string& stop_from, const std::string& stop_to) const{
+    return raptor_->FindParetoRoutes(stop_from, stop_to);
+}
+
+std::optional<Router::InRouter::RouteInfo> Router::BuildRoute(graph::VertexId from, graph::VertexId to, size_t& settled_count){
+    if (!route_cache_){
+        std::optional<InRouter::RouteInfo> route = router_->BuildRoute(from, to);
+        settled_count = router_->GetSettledCount();
+        return route;
+    }
+
+    if (const graph::ShortestPathTree<double>* tree = route_cache_->Find(from)){
+        settled_count = 0;
+        return tree->BuildRoute(to, graph_);
+    }
+    std::optional<graph::ShortestPathTree<double>> tree = router_->BuildShortestPathTree(from);
+    settled_count = router_->GetSettledCount();
+    if (!tree){
+        return router_->BuildRoute(from, to);
+    }
+    std::optional<InRouter::RouteInfo> route = tree->BuildRoute(to, graph_);
+    route_cache_->Insert(std::move(*tree)); // a tree exceeding the whole budget is dropped
+    return route;
+}
+
+std::optional<graph::RouteCacheStats> Router::GetRouteCacheStats() const{
+    if (!route_cache_){
+        return std::nullopt;
+    }
+    return route_cache_->GetStats();
+}
+
+std::optional<std::vector<std::pair<std::string_view, double>>> Router::FindReachableStops(const std::string& stop_from, double max_time){
+    std::optional<std::vector<std::pair<std::string_view, double>>> reachable;
+    if (config_.backend == RouterBackend::RAPTOR){
+        reachable = raptor_->FindReachableStops(stop_from, max_time);
+    }
+    else if (snapshot_){
+        reachable = snapshot_->FindReachableStops(stop_from, max_time);
+    }
+    else if (const auto it = stopname_to_vid_.find(stop_from); it != stopname_to_vid_.end()){
+        reachable.emplace();
+        for (const auto& [vid, time] : router_->ComputeReachableVertices(it->second, max_time)){
+            if (vid % 2 == 0){ // arrival vertices only, boarding ones include the wait
+                reachable->emplace_back(stop_names_[vid / 2], time);
+            }
+        }
+    }
+
+    if (reachable){
+        std::sort(reachable->begin(), reachable->end(), [](const auto& lhs, const auto& rhs){
+            return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+        });
+    }
+    return reachable;
+}
+
+std::vector<std::vector<std::optional<double>>> Router::ComputeTimeMatrix(const std::vector<std::string_view>& stops_from,
+                                                                          const std::vector<std::string_view>& stops_to){
+    std::vector<std::vector<std::optional<double>>> matrix;
+    matrix.reserve(stops_from.size());
+    if (config_.backend == RouterBackend::RAPTOR){
+        for (const std::string_view stop_from : stops_from){
+            matrix.push_back(raptor_->ComputeTimes(stop_from, stops_to));
+        }
+        return matrix;
+    }
+    if (snapshot_){
+        for (const std::string_view stop_from : stops_from){
+            matrix.push_back(snapshot_->ComputeTimes(stop_from, stops_to));
+        }
+        return matrix;
+    }
+
+    std::vector<graph::VertexId> to_vids; // known arrival stops only, `to_columns` maps them back to the matrix columns
+    std::vector<size_t> to_columns;
+    for (size_t column = 0; column < stops_to.size(); ++column){
+        if (const auto it = stopname_to_vid_.find(stops_to[column]); it != stopname_to_vid_.end()){
+            to_vids.push_back(it->second);
+            to_columns.push_back(column);
+        }
+    }
+
+    std::vector<graph::VertexId> from_vids; // the same for the rows
+    std::vector<size_t> from_rows;
+    for (size_t row = 0; row < stops_from.size(); ++row){
+        matrix.emplace_back(stops_to.size());
+        if (const auto it = stopname_to_vid_.find(stops_from[row]); it != stopname_to_vid_.end()){
+            from_vids.push_back(it->second);
+            from_rows.push_back(row);
+        }
+    }
+    if (graph_.GetEdgeCount() == 0){
+        return matrix;
+    }
+
+    // all of the rows at once, so that backends searching many-to-many share the searches from the arrival stops
+    const std::vector<std::vector<std::optional<double>>> times = router_->ComputeRouteWeightMatrix(from_vids, to_vids);
+    for (size_t i = 0; i < times.size(); ++i){
+        for (size_t j = 0; j < times[i].size(); ++j){
+            matrix[from_rows[i]][to_columns[j]] = times[i][j];
+        }
+    }
+    return matrix;
+}
+
 } // namespace Transportation
\ No newline at end of file